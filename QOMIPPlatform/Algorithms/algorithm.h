@@ -52,4 +52,49 @@ public:
     
     // 创建算法的深拷贝
     virtual Algorithm* clone() const = 0;
+    
+    // 输出是否依赖之前的帧（如背景模型、上一帧）
+    // 有状态算法必须按帧顺序在同一实例上执行，不能多帧并行
+    virtual bool isStateful() const { return false; }
+    
+    // 输出像素只依赖输入中半径范围内的行时返回该半径（逐点运算为0），
+    // 此时帧可以切成带重叠边的横条并行处理，且process()必须可被多线程同时调用；
+    // 返回-1表示不能分条处理（全局统计、检测器、尺寸变化等）
+    virtual int kernelRadius() const { return -1; }
+    
+    // 输出只依赖输入的亮度（单通道输入得到单通道结果，三通道输入只是把灰度结果转回三通道）时返回true，
+    // 链首为这类算法时直接以帧的亮度平面为输入，省去BGR转换和灰度转换
+    virtual bool isLumaOnly() const { return false; }
+    
+    // 检测类算法（结果是框、关键点等结构化数据）可以在缩小后的工作分辨率上检测：
+    // 在 analysisInput 上检测，结果坐标乘以 scale 映射回 displayInput，叠加层画在 displayInput 的副本上
+    virtual bool supportsScaledAnalysis() const { return false; }
+    virtual cv::Mat processScaled(const cv::Mat& analysisInput, const cv::Mat& displayInput, double scale)
+    {
+        (void)analysisInput;
+        (void)scale;
+        return process(displayInput);
+    }
+    
+protected:
+    // 把检测坐标从分析图像映射到显示图像
+    static cv::Rect scaleRect(const cv::Rect& rect, double scale)
+    {
+        if (scale == 1.0) {
+            return rect;
+        }
+        return cv::Rect(cvRound(rect.x * scale), cvRound(rect.y * scale),
+                        cvRound(rect.width * scale), cvRound(rect.height * scale));
+    }
+    
+    static void scaleKeyPoints(std::vector<cv::KeyPoint>& keypoints, double scale)
+    {
+        if (scale == 1.0) {
+            return;
+        }
+        for (cv::KeyPoint& kp : keypoints) {
+            kp.pt *= static_cast<float>(scale);
+            kp.size *= static_cast<float>(scale);
+        }
+    }
 };
@@ -85,4 +85,10 @@ QList<ParameterMeta> BlurFilter::getParametersMeta() const {
 
 Algorithm* BlurFilter::clone() const {
     return new BlurFilter(*this);
-}
\ No newline at end of file
+}
+
+int BlurFilter::kernelRadius() const {
+    // 与process()中一致，偶数核大小会被调整为奇数
+    int kernelSize = (m_kernelSize % 2 == 0) ? m_kernelSize + 1 : m_kernelSize;
+    return kernelSize / 2;
+}
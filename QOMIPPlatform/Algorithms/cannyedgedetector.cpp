@@ -10,7 +10,7 @@ cv::Mat CannyEdgeDetector::process(const cv::Mat& input) {
     if (input.channels() == 3) {
         cv::cvtColor(input, gray, cv::COLOR_BGR2GRAY);
     } else {
-        gray = input.clone();
+        gray = input;  // 只读使用，亮度平面输入时不拷贝
     }
     
     // 应用Canny边缘检测
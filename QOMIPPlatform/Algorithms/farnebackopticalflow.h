@@ -14,6 +14,7 @@ public:
     int getId() const override;
     QList<ParameterMeta> getParametersMeta() const override;
     Algorithm* clone() const override;
+    bool isStateful() const override { return true; }
     
 private:
     cv::Mat m_previousFrame;
@@ -13,6 +13,9 @@ public:
     int getId() const override;
     QList<ParameterMeta> getParametersMeta() const override;
     Algorithm* clone() const override;
+    bool isStateful() const override { return true; }
+    // 只输出掩膜时与颜色无关；在原图上画轮廓时需要彩色输入
+    bool isLumaOnly() const override { return m_showMotionOnly; }
     
 private:
     cv::Mat m_previousFrame;
@@ -8,7 +8,7 @@ cv::Mat GrayscaleAlgorithm::process(const cv::Mat& input) {
     
     // 如果已经是灰度图，直接返回
     if (input.channels() == 1) {
-        return input.clone();
+        return input;  // 帧像素只读共享，不需要拷贝
     }
     
     // 转换为灰度图
@@ -14,4 +14,6 @@ public:
     int getId() const override;
     QList<ParameterMeta> getParametersMeta() const override;
     Algorithm* clone() const override;
+    int kernelRadius() const override { return 0; }
+    bool isLumaOnly() const override { return true; }
 };
\ No newline at end of file
@@ -75,10 +75,15 @@ bool HaarFaceDetector::loadCascades() {
 }
 
 cv::Mat HaarFaceDetector::process(const cv::Mat& input) {
-    if (input.empty()) {
-        return input;
+    return processScaled(input, input, 1.0);
+}
+
+cv::Mat HaarFaceDetector::processScaled(const cv::Mat& analysisInput, const cv::Mat& displayInput, double scale) {
+    if (analysisInput.empty() || displayInput.empty()) {
+        return displayInput;
     }
     
+    const cv::Mat& input = displayInput;
     cv::Mat output = input.clone();
     
     // 如果级联分类器未加载，显示错误信息
@@ -93,40 +98,44 @@ cv::Mat HaarFaceDetector::process(const cv::Mat& input) {
     
     // 转换为灰度图进行检测
     cv::Mat gray;
-    if (input.channels() == 3) {
-        cv::cvtColor(input, gray, cv::COLOR_BGR2GRAY);
+    if (analysisInput.channels() == 3) {
+        cv::cvtColor(analysisInput, gray, cv::COLOR_BGR2GRAY);
     } else {
-        gray = input.clone();
+        gray = analysisInput.clone();
     }
     
     // 直方图均衡化提高检测率
     cv::equalizeHist(gray, gray);
     
+    // 最小人脸尺寸按显示分辨率设置，检测时换算到分析图像
+    const int minSize = std::max(1, cvRound(m_minSize / scale));
+    
     // 检测人脸
     std::vector<cv::Rect> faces;
     m_faceCascade.detectMultiScale(gray, faces, m_scaleFactor, m_minNeighbors, 
-        0, cv::Size(m_minSize, m_minSize));
+        0, cv::Size(minSize, minSize));
     
     // 绘制检测结果
     for (size_t i = 0; i < faces.size(); i++) {
         cv::Scalar faceColor = input.channels() == 3 ? cv::Scalar(255, 0, 255) : cv::Scalar(255);
+        const cv::Rect face = scaleRect(faces[i], scale);
         
         if (m_drawFeatures) {
             // 绘制人脸椭圆
-            cv::Point center(faces[i].x + faces[i].width/2, faces[i].y + faces[i].height/2);
+            cv::Point center(face.x + face.width/2, face.y + face.height/2);
             cv::ellipse(output, center, 
-                cv::Size(faces[i].width/2, faces[i].height/2), 
+                cv::Size(face.width/2, face.height/2), 
                 0, 0, 360, faceColor, 2);
         } else {
             // 绘制矩形框
-            cv::rectangle(output, faces[i], faceColor, 2);
+            cv::rectangle(output, face, faceColor, 2);
         }
         
         // 添加标签
         char label[50];
         sprintf(label, "Face %zu", i + 1);
         cv::putText(output, label, 
-            cv::Point(faces[i].x, faces[i].y - 5),
+            cv::Point(face.x, face.y - 5),
             cv::FONT_HERSHEY_SIMPLEX, 0.5, faceColor, 1);
         
         // 如果启用眼睛检测
@@ -134,14 +143,14 @@ cv::Mat HaarFaceDetector::process(const cv::Mat& input) {
             cv::Mat faceROI = gray(faces[i]);
             std::vector<cv::Rect> eyes;
             m_eyeCascade.detectMultiScale(faceROI, eyes, 1.1, 2, 0, 
-                cv::Size(m_minSize/4, m_minSize/4));
+                cv::Size(minSize/4, minSize/4));
             
             // 绘制眼睛
             for (size_t j = 0; j < eyes.size() && j < 2; j++) {
                 cv::Scalar eyeColor = input.channels() == 3 ? cv::Scalar(0, 255, 0) : cv::Scalar(200);
-                cv::Point eye_center(faces[i].x + eyes[j].x + eyes[j].width/2,
-                                    faces[i].y + eyes[j].y + eyes[j].height/2);
-                int radius = cvRound((eyes[j].width + eyes[j].height) * 0.25);
+                const cv::Rect eye = scaleRect(eyes[j] + faces[i].tl(), scale);
+                cv::Point eye_center(eye.x + eye.width/2, eye.y + eye.height/2);
+                int radius = cvRound((eye.width + eye.height) * 0.25);
                 cv::circle(output, eye_center, radius, eyeColor, 2);
             }
         }
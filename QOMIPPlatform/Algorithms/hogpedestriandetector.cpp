@@ -6,20 +6,25 @@ HOGPedestrianDetector::HOGPedestrianDetector()
 }
 
 cv::Mat HOGPedestrianDetector::process(const cv::Mat& input) {
-    if (input.empty()) {
-        return input;
+    return processScaled(input, input, 1.0);
+}
+
+cv::Mat HOGPedestrianDetector::processScaled(const cv::Mat& analysisInput, const cv::Mat& displayInput, double scale) {
+    if (analysisInput.empty() || displayInput.empty()) {
+        return displayInput;
     }
     
+    const cv::Mat& input = displayInput;
     cv::Mat output = input.clone();
     
     // HOG检测需要足够大的图像
     cv::Mat resized;
-    double scale = 1.0;
-    if (input.cols < 64 || input.rows < 128) {
-        scale = std::max(64.0 / input.cols, 128.0 / input.rows);
-        cv::resize(input, resized, cv::Size(), scale, scale);
+    double upscale = 1.0;
+    if (analysisInput.cols < 64 || analysisInput.rows < 128) {
+        upscale = std::max(64.0 / analysisInput.cols, 128.0 / analysisInput.rows);
+        cv::resize(analysisInput, resized, cv::Size(), upscale, upscale);
     } else {
-        resized = input;
+        resized = analysisInput;
     }
     
     // 检测行人
@@ -36,15 +41,8 @@ cv::Mat HOGPedestrianDetector::process(const cv::Mat& input) {
     // 绘制检测结果
     int detectionCount = 0;
     for (size_t i = 0; i < found.size(); i++) {
-        cv::Rect r = found[i];
-        
-        // 如果图像被缩放，需要调整矩形坐标
-        if (scale != 1.0) {
-            r.x /= scale;
-            r.y /= scale;
-            r.width /= scale;
-            r.height /= scale;
-        }
+        // 检测坐标先去掉为满足最小尺寸做的放大，再映射到显示分辨率
+        cv::Rect r = scaleRect(found[i], scale / upscale);
         
         // 绘制边界框
         cv::Scalar color = input.channels() == 3 ? cv::Scalar(0, 255, 0) : cv::Scalar(255);
@@ -13,6 +13,7 @@ public:
     int getId() const override;
     QList<ParameterMeta> getParametersMeta() const override;
     Algorithm* clone() const override;
+    int kernelRadius() const override { return 0; }
     
 private:
     int m_hMin, m_hMax;
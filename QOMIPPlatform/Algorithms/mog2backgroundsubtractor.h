@@ -15,6 +15,7 @@ public:
     int getId() const override;
     QList<ParameterMeta> getParametersMeta() const override;
     Algorithm* clone() const override;
+    bool isStateful() const override { return true; }
     
 private:
     cv::Ptr<cv::BackgroundSubtractorMOG2> m_pMOG2;
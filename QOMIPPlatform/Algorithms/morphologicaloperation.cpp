@@ -126,4 +126,15 @@ Algorithm* MorphologicalOperation::clone() const {
     copy->m_kernelShape = this->m_kernelShape;
     copy->m_iterations = this->m_iterations;
     return copy;
-}
\ No newline at end of file
+}
+
+int MorphologicalOperation::kernelRadius() const {
+    // 每次腐蚀或膨胀向外扩展一个核半径，共执行 iterations 次
+    int radius = (m_kernelSize / 2) * qMax(1, m_iterations);
+    
+    // 开、闭、顶帽、黑帽是先腐蚀后膨胀（或相反）的两遍运算
+    if (m_operation == 2 || m_operation == 3 || m_operation == 5 || m_operation == 6) {
+        radius *= 2;
+    }
+    return radius;
+}
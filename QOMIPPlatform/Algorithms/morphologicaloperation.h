@@ -13,6 +13,7 @@ public:
     int getId() const override;
     QList<ParameterMeta> getParametersMeta() const override;
     Algorithm* clone() const override;
+    int kernelRadius() const override;
     
 private:
     int m_operation;
@@ -11,15 +11,19 @@ void ORBFeatureDetector::updateORB() {
 }
 
 cv::Mat ORBFeatureDetector::process(const cv::Mat& input) {
-    if (input.empty() || !m_orb) {
-        return input;
+    return processScaled(input, input, 1.0);
+}
+
+cv::Mat ORBFeatureDetector::processScaled(const cv::Mat& analysisInput, const cv::Mat& displayInput, double scale) {
+    if (analysisInput.empty() || displayInput.empty() || !m_orb) {
+        return displayInput;
     }
     
     cv::Mat gray;
-    if (input.channels() == 3) {
-        cv::cvtColor(input, gray, cv::COLOR_BGR2GRAY);
+    if (analysisInput.channels() == 3) {
+        cv::cvtColor(analysisInput, gray, cv::COLOR_BGR2GRAY);
     } else {
-        gray = input.clone();
+        gray = analysisInput.clone();
     }
     
     // 检测关键点和计算描述子
@@ -27,6 +31,10 @@ cv::Mat ORBFeatureDetector::process(const cv::Mat& input) {
     cv::Mat descriptors;
     m_orb->detectAndCompute(gray, cv::noArray(), keypoints, descriptors);
     
+    // 关键点映射到显示分辨率后再绘制和统计
+    scaleKeyPoints(keypoints, scale);
+    
+    const cv::Mat& input = displayInput;
     cv::Mat output = input.clone();
     
     // 根据模式绘制关键点
@@ -7,6 +7,8 @@ public:
     ORBFeatureDetector();
     
     cv::Mat process(const cv::Mat& input) override;
+    bool supportsScaledAnalysis() const override { return true; }
+    cv::Mat processScaled(const cv::Mat& analysisInput, const cv::Mat& displayInput, double scale) override;
     void setParameters(const QVariantMap& params) override;
     QVariantMap getParameters() const override;
     QString getName() const override;
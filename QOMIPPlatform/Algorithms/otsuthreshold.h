@@ -13,6 +13,7 @@ public:
     int getId() const override;
     QList<ParameterMeta> getParametersMeta() const override;
     Algorithm* clone() const override;
+    bool isLumaOnly() const override { return true; }
     
 private:
     bool m_invert;
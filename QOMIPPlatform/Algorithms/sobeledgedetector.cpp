@@ -140,4 +140,9 @@ Algorithm* SobelEdgeDetector::clone() const {
     copy->m_delta = this->m_delta;
     copy->m_direction = this->m_direction;
     return copy;
-}
\ No newline at end of file
+}
+
+int SobelEdgeDetector::kernelRadius() const {
+    // ksize为1时使用3x1或1x3核，半径仍为1
+    return qMax(1, m_kernelSize / 2);
+}
@@ -13,6 +13,8 @@ public:
     int getId() const override;
     QList<ParameterMeta> getParametersMeta() const override;
     Algorithm* clone() const override;
+    int kernelRadius() const override;
+    bool isLumaOnly() const override { return true; }
     
 private:
     int m_kernelSize;
@@ -14,6 +14,8 @@ public:
     int getId() const override;
     QList<ParameterMeta> getParametersMeta() const override;
     Algorithm* clone() const override;
+    int kernelRadius() const override { return 0; }
+    bool isLumaOnly() const override { return true; }
     
 private:
     int m_threshold;
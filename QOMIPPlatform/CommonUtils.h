@@ -5,6 +5,7 @@
 #include <QFileDialog>
 #include <QDirIterator>
 #include "opencv2/opencv.hpp"
+#include "displayconvert.h"
 //FileFuction
 namespace CU {
 inline QVector<QString> pickMediaFilesFromDir(
@@ -50,7 +51,7 @@ inline QImage mat2QImage_deep(const cv::Mat& src)
     }
 }
 
-inline QImage matToQImage(const cv::Mat &src)
+inline QImage matToQImage(const cv::Mat &src, DisplayConvert::RangeTracker *tracker = nullptr)
 {
     if (src.empty()) return QImage();
 
@@ -58,8 +59,9 @@ inline QImage matToQImage(const cv::Mat &src)
     const int h = src.rows;
     const int ch = src.channels();
     const int depth = src.depth();   // CV_8U / CV_16U / CV_32F
-    const bool isBigEndian = QSysInfo::ByteOrder == QSysInfo::BigEndian;
+    const bool isLittleEndian = QSysInfo::ByteOrder == QSysInfo::LittleEndian;
 
+    // 能直接对应 QImage 格式的类型只引用数据，不转换
     switch (depth)
     {
     case CV_8U:
@@ -69,48 +71,32 @@ inline QImage matToQImage(const cv::Mat &src)
                           QImage::Format_Grayscale8);
         case 3:  return QImage(src.data, w, h, static_cast<int>(src.step),
                           QImage::Format_BGR888);
-
+        case 4:  if (isLittleEndian)    // 小端序下 BGRA 的内存布局即 ARGB32
+                     return QImage(src.data, w, h, static_cast<int>(src.step),
+                                   QImage::Format_ARGB32);
+                 break;
         default: break;
         }
         break;
 
     case CV_16U:
-        switch (ch)
-        {
-        case 1:  return QImage(src.data, w, h, static_cast<int>(src.step),
+        if (ch == 1)
+            return QImage(src.data, w, h, static_cast<int>(src.step),
                           QImage::Format_Grayscale16);
-        case 3:  return QImage(src.data, w, h, static_cast<int>(src.step),
-                          QImage::Format_RGB32);   // 16bit RGB
-        case 4:  return QImage(src.data, w, h, static_cast<int>(src.step),
-                          QImage::Format_RGBA64);  // 16bit RGBA
-        default: break;
-        }
-        break;
+        break;   // 16 位彩色没有 BGR 顺序的 QImage 格式
 
-    case CV_32F:
-        // 32F 没有直接格式，转成 32F 灰度/彩色需手动归一化
-        // 这里简单返回空，需要时自己扩展
+    default:
         break;
     }
 
-    // 兜底：转 8U 后再转 QImage
-    cv::Mat tmp;
-    if (depth == CV_32F)
-    {
-        cv::normalize(src, tmp, 0, 255, cv::NORM_MINMAX);
-        tmp.convertTo(tmp, CV_8U);
-    }
-    else
-    {
-        src.convertTo(tmp, CV_8U);
-    }
-
-    if (tmp.channels() == 3)
-        cv::cvtColor(tmp, tmp, cv::COLOR_BGR2RGB);
-
-    return QImage(tmp.data, tmp.cols, tmp.rows, static_cast<int>(tmp.step),
-                  tmp.channels() == 1 ? QImage::Format_Grayscale8
-                                      : QImage::Format_RGB888).copy();
+    // 其它类型（16 位彩色、浮点等）：单遍转换为显示格式，QImage 持有转换结果
+    // 浮点图像传入 tracker 时沿用上一帧的取值范围，只需一遍
+    cv::Mat display;
+    if (!DisplayConvert::convertForDisplay(src, display, tracker))
+        return QImage();
+    return QImage(display.data, display.cols, display.rows, static_cast<int>(display.step),
+                  DisplayConvert::displayFormat(),
+                  [](void *info) { delete static_cast<cv::Mat*>(info); }, new cv::Mat(display));
 }
 
 /**
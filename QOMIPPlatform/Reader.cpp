@@ -1,5 +1,20 @@
 #include "Reader.h"
+#include "framecreditpool.h"
+#include "captureframesource.h"
+#include "cachedframesource.h"
+#include "imagesequencesource.h"
 #include <QDebug>
+#include <QFileInfo>
+#include <QSettings>
+#include <QThread>
+#include <atomic>
+
+namespace {
+
+// 帧序号在所有 Reader 之间全局递增，不同输入源的帧不会使用相同的序号
+std::atomic<quint64> g_nextSequence{0};
+
+} // namespace
 
 Reader::Reader(QObject *parent)
     : QObject(parent), m_running(true), m_play(false)
@@ -10,6 +25,13 @@ Reader::Reader(QObject *parent)
     
     // 连接定时器的timeout信号到处理帧的槽函数
     connect(m_timer, &QTimer::timeout, this, &Reader::processFrame);
+    
+    // 解码线程预取的帧数
+    QSettings settings("QOMIPPlatform", "Reader");
+    m_prefetchFrames = qMax(1, settings.value("prefetch_frames", 4).toInt());
+    m_nativeYuv = settings.value("native_yuv", false).toBool();
+    m_imageFps = settings.value("image_sequence_fps", 25.0).toDouble();
+    m_imageDecodeAhead = qMax(1, settings.value("image_decode_ahead", QThread::idealThreadCount()).toInt());
 }
 
 Reader::~Reader()
@@ -18,34 +40,124 @@ Reader::~Reader()
     stop();
 }
 
+void Reader::setCreditPool(FrameCreditPool *pool) {
+    QMutexLocker lock(&m_mutex);
+    m_creditPool = pool;
+}
+
+void Reader::retirePrefetcher() {
+    // 此方法假设已经持有锁
+    retire(m_prefetcher);
+    retire(m_nextPrefetcher);
+}
+
+void Reader::retire(std::unique_ptr<FramePrefetcher> &prefetcher) {
+    // 此方法假设已经持有锁
+    if (!prefetcher) {
+        return;
+    }
+    
+    // 解码线程可能正在解码一帧：只请求退出，在单独的线程中等待并销毁，控制调用不被阻塞。
+    // 不能交给线程池：解码线程可能正在等待线程池中的任务，工作线程在这里等待它会互相阻塞
+    m_lateFramesRetired += prefetcher->lateGrabbed();
+    FramePrefetcher *old = prefetcher.release();
+    old->requestStop();
+    QThread *reaper = QThread::create([old]() { delete old; });
+    reaper->setObjectName("PrefetcherReaper");
+    connect(reaper, &QThread::finished, reaper, &QObject::deleteLater);
+    reaper->start();
+}
+
+bool Reader::isRecordedSource() const {
+    // 此方法假设已经持有锁
+    return m_sourceType == SOURCE_FILE || m_sourceType == SOURCE_IMAGES;
+}
+
+int Reader::currentInterval() const {
+    // 此方法假设已经持有锁
+    if (m_sourceType == SOURCE_IMAGES && m_imageFps <= 0.0) {
+        return 0;   // 图像序列设置为不按时间播放
+    }
+    return (m_maxThroughput && isRecordedSource()) ? 0 : m_frameInterval;
+}
+
 void Reader::setSource(const QString &file) {
     QMutexLocker lock(&m_mutex);
     m_path = file;
     m_sourceType = SOURCE_FILE;
     m_cameraIndex = -1;  // 清除摄像头索引
+    m_playlist.clear();
+    m_playlistIndex = -1;
     
     // 如果已经打开一个视频，先关闭它
-    if (m_cap.isOpened()) {
-        m_cap.release();
-    }
+    retirePrefetcher();
+    m_mediaAnchorMs = -1;
 
     qDebug()<<"Current Source is file: "<<file;
 }
 
+void Reader::setPlaylist(const QStringList &files, int startIndex) {
+    QMutexLocker lock(&m_mutex);
+    if (files.isEmpty()) {
+        return;
+    }
+    m_playlist = files;
+    m_playlistIndex = qBound(0, startIndex, files.size() - 1);
+    m_path = files[m_playlistIndex];
+    m_sourceType = SOURCE_FILE;
+    m_cameraIndex = -1;
+    
+    retirePrefetcher();
+    m_mediaAnchorMs = -1;
+    
+    qDebug() << "Current Source is playlist:" << files.size() << "files, starting at" << m_path;
+}
+
 void Reader::setCameraSource(int cameraIndex) {
     QMutexLocker lock(&m_mutex);
     m_cameraIndex = cameraIndex;
     m_sourceType = SOURCE_CAMERA;
     m_path.clear();  // 清除文件路径
+    m_playlist.clear();
+    m_playlistIndex = -1;
     
     // 如果已经打开一个源，先关闭它
-    if (m_cap.isOpened()) {
-        m_cap.release();
-    }
+    retirePrefetcher();
+    m_mediaAnchorMs = -1;
     
     qDebug() << "Current Source is camera index:" << cameraIndex;
 }
 
+void Reader::setEmulatedCameraSource(const QString &file) {
+    QMutexLocker lock(&m_mutex);
+    m_path = file;
+    m_sourceType = SOURCE_CAMERA;
+    m_cameraIndex = -1;     // 摄像头索引为-1、路径非空表示模拟摄像头
+    m_playlist.clear();
+    m_playlistIndex = -1;
+    
+    retirePrefetcher();
+    m_mediaAnchorMs = -1;
+    
+    qDebug() << "Current Source is emulated camera:" << file;
+}
+
+void Reader::setImageSequence(const QStringList &files) {
+    QMutexLocker lock(&m_mutex);
+    m_imageFiles = files;
+    m_sourceType = SOURCE_IMAGES;
+    m_cameraIndex = -1;
+    m_playlist.clear();
+    m_playlistIndex = -1;
+    m_path = files.isEmpty() ? QString() : QFileInfo(files.first()).absolutePath();
+    
+    // 如果已经打开一个源，先关闭它
+    retirePrefetcher();
+    m_mediaAnchorMs = -1;
+    
+    qDebug() << "Current Source is image sequence:" << m_path << "images:" << files.size();
+}
+
 void Reader::setViewCount(int count) {
     QMutexLocker lock(&m_mutex);
     r_videoNumber = qMax(1, count); // 至少需要1个视图
@@ -57,16 +169,113 @@ void Reader::setFrameRate(int fps) {
     
     // 如果定时器正在运行，更新其间隔
     if (m_timer->isActive()) {
-        m_timer->setInterval(m_frameInterval);
+        m_timer->setInterval(currentInterval());
+    }
+}
+
+void Reader::setMaxThroughput(bool enabled) {
+    QMutexLocker lock(&m_mutex);
+    m_maxThroughput = enabled;
+    m_mediaAnchorMs = -1;
+    m_timer->setInterval(currentInterval());
+    
+    // 最大吞吐模式不跳帧，解码线程始终输出像素
+    if (m_prefetcher) {
+        m_prefetcher->setSkipWhenSaturated(currentInterval() > 0);
+    }
+    
+    // 退出最大吞吐模式时恢复按帧率定时
+    if (!enabled && (m_waitingForCredit || m_waitingForFrame)) {
+        m_waitingForCredit = false;
+        m_waitingForFrame = false;
+        if (m_play) {
+            m_timer->start();
+        }
+    }
+    qDebug() << "[Reader]: max throughput mode" << enabled;
+}
+
+void Reader::onCreditsAvailable() {
+    QMutexLocker lock(&m_mutex);
+    if (!m_waitingForCredit) {
+        return;
+    }
+    m_waitingForCredit = false;
+    if (m_play && !m_timer->isActive()) {
+        m_timer->start();
+    }
+}
+
+void Reader::onFramesAvailable() {
+    QMutexLocker lock(&m_mutex);
+    if (m_previewPending && !m_play && m_prefetcher) {
+        // 暂停时定位：显示定位后的第一帧
+        PrefetchedFrame prefetched;
+        if (m_prefetcher->tryPop(prefetched) && prefetched.decoded) {
+            m_previewPending = false;
+            emitFrame(prefetched);
+        }
+        return;
+    }
+    if (m_play && m_prefetcher && m_prefetcher->isLive()) {
+        // 实时源：邮箱中有新帧就立即发送，不等下一次定时器
+        lock.unlock();
+        processFrame();
+        return;
+    }
+    if (!m_waitingForFrame) {
+        return;
+    }
+    m_waitingForFrame = false;
+    if (m_play && !m_timer->isActive()) {
+        // 立即取帧；按时间戳播放时 processFrame 会重新设定下一次触发时间
+        m_timer->start(0);
+    }
+}
+
+void Reader::seek(qint64 timestampMs) {
+    seekTo(timestampMs, false);
+}
+
+void Reader::scrub(qint64 timestampMs) {
+    seekTo(timestampMs, true);
+}
+
+void Reader::seekToFrame(int frame) {
+    double fps = 0.0;
+    {
+        QMutexLocker lock(&m_mutex);
+        fps = m_prefetcher ? m_prefetcher->nominalFps() : 0.0;
     }
+    seekTo(qRound64(qMax(0, frame) * 1000.0 / (fps > 0.0 ? fps : 30.0)), false);
+}
+
+void Reader::seekTo(qint64 timestampMs, bool keyframeOnly) {
+    QMutexLocker lock(&m_mutex);
+    if (!isRecordedSource()) {
+        return;     // 实时源不能定位
+    }
+    if (!m_prefetcher && !openSource()) {
+        return;
+    }
+    
+    // 解码线程中异步定位；播放时钟以定位后的第一帧重新对齐
+    m_prefetcher->seek(timestampMs, keyframeOnly);
+    m_mediaAnchorMs = -1;
+    m_previewPending = !m_play;
 }
 
 void Reader::play() { 
     QMutexLocker lock(&m_mutex); 
     m_play = true;
+    m_previewPending = false;
+    m_waitingForCredit = false;
+    m_waitingForFrame = false;
+    m_mediaAnchorMs = -1;   // 暂停期间不计入播放时钟
     
     // 如果定时器未启动，则启动它
     if (!m_timer->isActive()) {
+        m_timer->setInterval(currentInterval());
         m_timer->start();
     }
     qDebug() << "[Reader]:Now , play function is called";
@@ -88,76 +297,116 @@ void Reader::stop() {
     }
     
     m_path.clear();
+    m_imageFiles.clear();
+    m_playlist.clear();
+    m_playlistIndex = -1;
     m_cameraIndex = -1;
     m_sourceType = SOURCE_NONE;
     
-    if (m_cap.isOpened()) {
-        m_cap.release();
-    }
+    retirePrefetcher();
     
     emit processingFinished("视频处理已停止");
 }
 
 bool Reader::openSource() {
     // 此方法假设已经持有锁
-    if (m_cap.isOpened()) {
+    if (m_prefetcher) {
         return true;  // 已经打开
     }
     
-    bool success = false;
-    
+    std::unique_ptr<FrameSource> source;
     switch (m_sourceType) {
         case SOURCE_FILE:
             if (!m_path.isEmpty()) {
-                success = m_cap.open(m_path.toStdString());
-                if (!success) {
-                    qWarning() << "无法打开视频文件：" << m_path;
-                    emit processingFinished("无法打开视频文件: " + m_path);
-                }
+                source = createFileSource(m_path);
             }
             break;
             
         case SOURCE_CAMERA:
             if (m_cameraIndex >= 0) {
-                // 尝试使用适合平台的后端打开摄像头
-                #ifdef Q_OS_WIN
-                    success = m_cap.open(m_cameraIndex, cv::CAP_DSHOW);
-                #elif defined(Q_OS_MAC)
-                    success = m_cap.open(m_cameraIndex, cv::CAP_AVFOUNDATION);
-                #elif defined(Q_OS_LINUX)
-                    success = m_cap.open(m_cameraIndex, cv::CAP_V4L2);
-                #else
-                    success = m_cap.open(m_cameraIndex);
-                #endif
-                
-                if (!success) {
-                    // 如果特定后端失败，尝试默认后端
-                    success = m_cap.open(m_cameraIndex);
-                }
-                
-                if (!success) {
-                    qWarning() << "无法打开摄像头：" << m_cameraIndex;
-                    emit processingFinished(QString("无法打开摄像头 %1").arg(m_cameraIndex));
-                } else {
-                    // 设置摄像头参数（可选）
-                    // m_cap.set(cv::CAP_PROP_FRAME_WIDTH, 640);
-                    // m_cap.set(cv::CAP_PROP_FRAME_HEIGHT, 480);
-                    // m_cap.set(cv::CAP_PROP_FPS, 30);
-                    qDebug() << "Successfully opened camera" << m_cameraIndex;
-                }
+                source = std::make_unique<CaptureFrameSource>(m_cameraIndex, m_nativeYuv);
+            } else if (!m_path.isEmpty()) {
+                source = std::make_unique<CaptureFrameSource>(m_path, m_nativeYuv, true);
+            }
+            break;
+            
+        case SOURCE_IMAGES:
+            if (!m_imageFiles.isEmpty()) {
+                source = std::make_unique<ImageSequenceSource>(m_imageFiles, m_imageFps, m_imageDecodeAhead);
             }
             break;
             
         case SOURCE_NONE:
         default:
-            qWarning() << "No source set";
-            return false;
+            break;
     }
     
-    return success;
+    if (!source) {
+        qWarning() << "No source set";
+        return false;
+    }
+    
+    // 打开和解码都在预取线程中进行，这里立即返回；打开失败在取帧时报告
+    m_prefetcher = std::make_unique<FramePrefetcher>(std::move(source), m_prefetchFrames, m_creditPool);
+    activatePrefetcher();
+    m_prefetcher->start();
+    preloadNext();
+    return true;
+}
+
+std::unique_ptr<FrameSource> Reader::createFileSource(const QString &path) const {
+    std::unique_ptr<FrameSource> source = std::make_unique<CaptureFrameSource>(path, m_nativeYuv);
+    if (DecodedFrameCache::instance().isEnabled()) {
+        // 短片段循环播放时，回绕和定位直接从解码帧缓存取帧
+        source = std::make_unique<CachedFrameSource>(std::move(source), path);
+    }
+    return source;
+}
+
+void Reader::activatePrefetcher() {
+    // 此方法假设已经持有锁
+    m_prefetcher->setSkipWhenSaturated(currentInterval() > 0);
+    m_prefetcher->setNotifyCallback([this]() {
+        QMetaObject::invokeMethod(this, "onFramesAvailable", Qt::QueuedConnection);
+    });
+}
+
+void Reader::preloadNext() {
+    // 此方法假设已经持有锁
+    if (m_nextPrefetcher || m_playlistIndex < 0 || m_playlistIndex + 1 >= m_playlist.size()) {
+        return;
+    }
+    
+    // 预取线程打开文件并解码前几帧后休眠；切换前不跳帧，也不通知
+    m_nextPrefetcher = std::make_unique<FramePrefetcher>(createFileSource(m_playlist[m_playlistIndex + 1]),
+                                                         m_prefetchFrames, m_creditPool);
+    m_nextPrefetcher->setSkipWhenSaturated(false);
+    m_nextPrefetcher->start();
+}
+
+bool Reader::advancePlaylist() {
+    // 此方法假设已经持有锁
+    if (m_playlistIndex < 0 || m_playlistIndex + 1 >= m_playlist.size()) {
+        return false;
+    }
+    
+    retire(m_prefetcher);
+    m_path = m_playlist[++m_playlistIndex];
+    if (m_nextPrefetcher) {
+        m_prefetcher = std::move(m_nextPrefetcher);
+        activatePrefetcher();
+        preloadNext();
+    } else {
+        openSource();
+    }
+    
+    // 播放时钟以新文件的第一帧重新对齐
+    m_mediaAnchorMs = -1;
+    qDebug() << "[Reader]: playlist advanced to" << m_playlistIndex + 1 << "/" << m_playlist.size() << m_path;
+    emit playlistIndexChanged(m_playlistIndex, m_path);
+    return true;
 }
 
-// 在 Reader.cpp 中修改
 void Reader::processFrame() {
     QMutexLocker lock(&m_mutex);
     
@@ -171,43 +420,170 @@ void Reader::processFrame() {
         return;
     }
     
-    // 如果视频捕获未打开，尝试打开
-    if (!m_cap.isOpened()) {
-        if (!openSource()) {
-            return;  // 无法打开源
+    // 如果输入源未打开，启动预取线程打开它
+    if (!m_prefetcher && !openSource()) {
+        return;
+    }
+    
+    // 最大吞吐模式不跳帧：所有处理器都已饱和时停下定时器，等处理端空出位置再继续
+    const bool unpaced = currentInterval() == 0;
+    const bool hasCredit = !m_creditPool || m_creditPool->hasCredit();
+    if (!hasCredit && unpaced) {
+        m_timer->stop();
+        m_waitingForCredit = true;
+        return;
+    }
+    
+    // 文件源按容器时间戳对齐单调时钟播放，不再依赖整数毫秒的定时器间隔
+    const bool paced = !unpaced && isRecordedSource();
+    
+    // 按固定间隔读取的输入源：在读取线程中跟随当前输入源更新定时器间隔
+    // （设置输入源的函数可能在GUI线程中直接调用，不能在那里操作定时器）
+    if (!paced && m_timer->interval() != currentInterval()) {
+        m_timer->setInterval(currentInterval());
+    }
+    qint64 headTimestamp = 0;
+    if (paced && m_prefetcher->peekTimestamp(headTimestamp)) {
+        const qint64 now = mediaClock(headTimestamp);
+        if (headTimestamp > now) {
+            // 还没到这一帧的显示时间：定时器改为在它到期时触发
+            m_timer->start(static_cast<int>(qBound<qint64>(1, headTimestamp - now, 1000)));
+            return;
         }
     }
     
-    // 读取一帧
-    cv::Mat frame;
-    if (m_cap.read(frame)) {
-        if (!frame.empty()) {
-            // 直接发送原始帧，不再创建帧组
-            emit frameReady(frame);
+    // 只从预取缓冲中取帧，不在这里解码
+    PrefetchedFrame prefetched;
+    if (!m_prefetcher->tryPop(prefetched)) {
+        switch (m_prefetcher->state()) {
+        case FramePrefetcher::State::Failed:
+            qWarning() << "无法打开输入源：" << m_prefetcher->description();
+            if (advancePlaylist()) {
+                // 播放列表跳过无法打开的文件
+                m_timer->start(0);
+                break;
+            }
+            m_play = false;
+            emit processingFinished(m_sourceType == SOURCE_CAMERA
+                                    ? "无法打开" + m_prefetcher->description()
+                                    : m_sourceType == SOURCE_IMAGES
+                                    ? "无法打开图像序列: " + m_path
+                                    : "无法打开视频文件: " + m_path);
+            retirePrefetcher();
+            break;
             
-            // 每100帧输出一次debug信息，减少输出频率
-            m_frameCounter++;
-            if (m_frameCounter % 100 == 0) {
-                qDebug() << "已读取并发送第" << m_frameCounter << "帧";
+        case FramePrefetcher::State::EndOfStream:
+            if (advancePlaylist()) {
+                // 下一个文件已在后台打开并预取：立即从它取帧，不停顿
+                m_timer->start(0);
+                break;
             }
-        }
-    } else {
-        // 处理结束情况
-        if (m_sourceType == SOURCE_FILE) {
+            
             // 视频文件结束
             qDebug() << "视频播放完毕";
             m_play = false;
             
             emit processingFinished("视频播放完毕");
             
-            // 重置视频，便于再次播放
-            if (m_cap.isOpened()) {
-                m_cap.set(cv::CAP_PROP_POS_FRAMES, 0);
+            // 重置视频，便于再次播放（预取线程会重新填充缓冲）
+            m_prefetcher->rewind();
+            m_mediaAnchorMs = -1;
+            break;
+            
+        default:
+            // 解码暂时没跟上：摄像头跳过这一拍；文件源等有帧再继续，届时丢弃过期帧追上时钟
+            if (unpaced || paced) {
+                m_timer->stop();
+                m_waitingForFrame = true;
+            }
+            break;
+        }
+        return;
+    }
+    
+    // 实时源取走邮箱中的帧后立即请求下一帧；处理端饱和时请求保留到有空位
+    if (m_prefetcher->isLive()) {
+        m_prefetcher->requestFrame();
+    }
+    
+    if (paced) {
+        const qint64 now = mediaClock(prefetched.timestampMs);
+        
+        // 后面的帧也已到期：当前帧已经过时，丢弃以保持实时
+        qint64 nextTimestamp = 0;
+        while (m_prefetcher->peekTimestamp(nextTimestamp) && nextTimestamp <= now) {
+            PrefetchedFrame newer;
+            if (!m_prefetcher->tryPop(newer)) {
+                break;
             }
-        } else if (m_sourceType == SOURCE_CAMERA) {
-            // 摄像头读取失败，可能是暂时的问题
-            qWarning() << "Failed to read frame from camera";
-            // 不停止播放，继续尝试
+            prefetched = std::move(newer);
+            m_lateFrames++;
         }
+        
+        // 解码线程本身落后时由它直接grab()丢弃，不再解码注定过期的帧
+        m_prefetcher->setDiscardBefore(now);
+        m_driftMs = now - prefetched.timestampMs;
+        m_maxDriftMs = qMax(m_maxDriftMs, m_driftMs);
+        
+        // 定时器对准下一帧的到期时间；缓冲为空时先按帧间隔轮询
+        qint64 delay = m_frameInterval;
+        if (m_prefetcher->peekTimestamp(nextTimestamp)) {
+            delay = nextTimestamp - (m_mediaAnchorMs + m_playClock.elapsed());
+        }
+        m_timer->start(static_cast<int>(qBound<qint64>(1, delay, 1000)));
+    }
+    
+    // 所有处理器都已饱和，或解码线程因饱和只grab()了这一帧：不发送
+    if (!hasCredit || !prefetched.decoded) {
+        m_skippedFrames++;
+        if (m_skippedFrames % 100 == 0) {
+            qDebug() << "处理端饱和，已跳过" << m_skippedFrames << "帧";
+        }
+        return;
+    }
+    
+    emitFrame(prefetched);
+    
+    // 每100帧输出一次debug信息，减少输出频率
+    m_frameCounter++;
+    if (m_frameCounter % 100 == 0) {
+        qDebug() << "已读取并发送第" << m_frameCounter << "帧";
+        if (paced) {
+            qDebug() << "[Reader]: drift" << m_driftMs << "ms, max" << m_maxDriftMs
+                     << "ms, late frames" << m_lateFrames + m_prefetcher->lateGrabbed();
+        }
+    }
+}
+
+void Reader::emitFrame(const PrefetchedFrame& prefetched) {
+    // 此方法假设已经持有锁
+    // 包装成共享帧发送，各视图共用同一份像素；分发完成前计为在途帧
+    if (m_creditPool) {
+        m_creditPool->reserveFrame();
+    }
+    emit frameReady(SharedFrame(prefetched.image, prefetched.format,
+                                ++g_nextSequence, prefetched.timestampMs, prefetched.captureTimeUs));
+    emit positionChanged(prefetched.timestampMs,
+                         isRecordedSource() && m_prefetcher ? m_prefetcher->durationMs() : -1);
+}
+
+qint64 Reader::mediaClock(qint64 firstTimestampMs) {
+    // 此方法假设已经持有锁
+    if (m_mediaAnchorMs < 0) {
+        // 开始播放、恢复或回绕后，以第一帧的时间戳为时钟零点
+        m_mediaAnchorMs = firstTimestampMs;
+        m_playClock.restart();
     }
+    return m_mediaAnchorMs + m_playClock.elapsed();
+}
+
+Reader::PlaybackStats Reader::playbackStats() const {
+    QMutexLocker lock(&m_mutex);
+    PlaybackStats stats;
+    stats.sourceFps = m_prefetcher ? m_prefetcher->nominalFps() : 0.0;
+    stats.driftMs = m_driftMs;
+    stats.maxDriftMs = m_maxDriftMs;
+    stats.lateFrames = m_lateFrames + m_lateFramesRetired + (m_prefetcher ? m_prefetcher->lateGrabbed() : 0);
+    stats.skippedFrames = m_skippedFrames;
+    return stats;
 }
@@ -3,14 +3,24 @@
 #include <QObject>
 #include <QMutex>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <opencv2/opencv.hpp>
+#include <memory>
 #include <vector>
+#include "sharedframe.h"
+#include "frameprefetcher.h"
+
+class FrameCreditPool;
 
 /**
  * @class Reader
  * @brief 视频读取工作类，负责从视频文件或摄像头读取帧并定时发送
  * 
- * 设计为与QThread配合使用，通过moveToThread移动到线程中执行
+ * 设计为与QThread配合使用，通过moveToThread移动到线程中执行。
+ * 解码由 FramePrefetcher 的独立线程提前完成，定时器只从预取缓冲中取帧。
+ * 文件源按容器时间戳对齐单调时钟播放，处理落后时丢弃过期帧以保持实时。
+ * 摄像头不经定时器排队：预取线程的单帧邮箱一有新帧就立即发送，取走后再请求下一帧。
+ * 播放列表模式下，下一个文件在后台提前打开并预取，当前文件结束时无停顿地切换。
  */
 class Reader : public QObject {
     Q_OBJECT
@@ -21,7 +31,19 @@ public:
     enum SourceType {
         SOURCE_NONE,    ///< 无输入源
         SOURCE_FILE,    ///< 文件输入
-        SOURCE_CAMERA   ///< 摄像头输入
+        SOURCE_CAMERA,  ///< 摄像头输入
+        SOURCE_IMAGES   ///< 图像序列输入
+    };
+    
+    /**
+     * @brief 播放节奏统计
+     */
+    struct PlaybackStats {
+        double sourceFps = 0.0;     ///< 输入源标称帧率，未知时为0
+        qint64 driftMs = 0;         ///< 最近发送的帧相对播放时钟的延迟(毫秒)
+        qint64 maxDriftMs = 0;      ///< 最大延迟(毫秒)
+        quint64 lateFrames = 0;     ///< 为保持实时而丢弃的过期帧数
+        quint64 skippedFrames = 0;  ///< 因处理端饱和而跳过的帧数
     };
     
     /**
@@ -31,6 +53,22 @@ public:
     explicit Reader(QObject *parent = nullptr);
     ~Reader();
     
+    /**
+     * @brief 设置信用池，需在移动到读取线程前调用
+     * @param pool 处理端的信用池，为nullptr时不做背压控制
+     */
+    void setCreditPool(FrameCreditPool *pool);
+    
+    /**
+     * @brief 因处理端饱和而跳过解码的帧数
+     */
+    quint64 skippedFrameCount() const { return m_skippedFrames; }
+    
+    /**
+     * @brief 播放延迟与丢帧统计（线程安全）
+     */
+    PlaybackStats playbackStats() const;
+    
     
 
 public slots:
@@ -60,12 +98,36 @@ public slots:
      */
     void setSource(const QString &file);
     
+    /**
+     * @brief 设置播放列表：从 startIndex 开始依次连续播放
+     * 
+     * 播放当前文件时下一个文件已在后台打开并预取前几帧，结束时直接切换，
+     * 中间不报告播放结束；无法打开的文件跳过。
+     * @param files 视频文件列表
+     * @param startIndex 第一个播放的文件
+     */
+    void setPlaylist(const QStringList &files, int startIndex);
+    
     /**
      * @brief 设置摄像头源
      * @param cameraIndex 摄像头索引
      */
     void setCameraSource(int cameraIndex);
     
+    /**
+     * @brief 把视频文件作为模拟摄像头：按帧率实时出帧、循环播放，走与摄像头相同的实时路径
+     * @param file 视频文件路径
+     */
+    void setEmulatedCameraSource(const QString &file);
+    
+    /**
+     * @brief 设置图像序列源，按给定顺序逐张播放
+     * 
+     * 播放帧率为QSettings `Reader/image_sequence_fps`，<=0 时不按时间播放。
+     * @param files 图像文件列表
+     */
+    void setImageSequence(const QStringList &files);
+    
     /**
      * @brief 设置需要处理的视频窗口数量
      * @param count 窗口数量
@@ -73,28 +135,84 @@ public slots:
     void setViewCount(int count);
     
     /**
-     * @brief 设置视频播放的帧率
+     * @brief 设置取帧帧率
+     * 
+     * 文件源按容器时间戳播放，摄像头在新帧到达时立即发送，此值仅用于缓冲为空时的轮询间隔。
      * @param fps 每秒帧数，默认为30
      */
     void setFrameRate(int fps = 30);
     
+    /**
+     * @brief 设置最大吞吐模式（仅对文件源生效）
+     * @param enabled 为true时不按帧率定时，处理端一有空位就读取下一帧，且不跳帧
+     */
+    void setMaxThroughput(bool enabled);
+    
+    /**
+     * @brief 处理端重新有空位时调用，恢复因等待信用而暂停的读取
+     */
+    void onCreditsAvailable();
+    
+    /**
+     * @brief 预取缓冲有新帧或状态变化时调用，恢复因等待解码而暂停的读取
+     */
+    void onFramesAvailable();
+    
+    /**
+     * @brief 定位到指定时间（仅文件和图像序列）
+     * 
+     * 有关键帧索引时从目标之前最近的关键帧向前解码到目标帧。暂停时显示定位后的一帧。
+     * @param timestampMs 目标时间(毫秒)
+     */
+    void seek(qint64 timestampMs);
+    
+    /**
+     * @brief 定位到指定帧号
+     */
+    void seekToFrame(int frame);
+    
+    /**
+     * @brief 拖动预览：只定位到目标之前最近的关键帧并显示该帧，不向前解码
+     */
+    void scrub(qint64 timestampMs);
+    
     /**
      * @brief 获取当前输入源类型
      */
     SourceType getSourceType() const { return m_sourceType; }
     
-    // 获取当前源文件路径
+    // 获取当前源文件路径（图像序列为所在目录，模拟摄像头为视频文件）
     QString getCurrentSourcePath() const { return m_path; }
     
-    // 获取当前摄像头索引
+    // 获取当前播放列表（非列表模式为空）
+    QStringList getCurrentPlaylist() const { return m_playlist; }
+    
+    // 获取当前图像序列
+    QStringList getCurrentImageSequence() const { return m_imageFiles; }
+    
+    // 获取当前摄像头索引（模拟摄像头为-1）
     int getCurrentCameraIndex() const { return m_cameraIndex; }
     
 signals:
     /**
      * @brief 当新帧准备好时发出此信号
-     * @param mats 帧组，包含原始帧和多种处理效果的帧
+     * @param frame 共享的不可变帧，携带帧序号和时间戳，所有视图共用同一份像素
      */
-    void frameReady(const cv::Mat& frame);
+    void frameReady(const SharedFrame& frame);
+    
+    /**
+     * @brief 发送一帧后报告播放位置
+     * @param timestampMs 该帧的时间戳(毫秒)
+     * @param durationMs 输入源时长(毫秒)，未知或实时源为-1
+     */
+    void positionChanged(qint64 timestampMs, qint64 durationMs);
+    
+    /**
+     * @brief 播放列表切换到下一个文件
+     * @param index 文件在列表中的位置
+     * @param path 文件路径
+     */
+    void playlistIndexChanged(int index, const QString &path);
     
     
     /**
@@ -106,18 +224,93 @@ signals:
 private:
     QString m_path;             ///< 视频文件路径
     int m_cameraIndex = -1;     ///< 摄像头索引
+    QStringList m_imageFiles;   ///< 图像序列文件列表
+    QStringList m_playlist;     ///< 播放列表，为空表示不在列表模式
+    int m_playlistIndex = -1;   ///< 当前文件在播放列表中的位置
     SourceType m_sourceType = SOURCE_NONE;  ///< 当前输入源类型
-    QMutex m_mutex;             ///< 互斥锁，用于线程安全
+    mutable QMutex m_mutex;     ///< 互斥锁，用于线程安全
     bool m_running = true;      ///< 运行标志
     bool m_play = false;        ///< 播放状态标志
     int r_videoNumber = 1;      ///< 需要输出的矩阵个数
-    cv::VideoCapture m_cap;     ///< OpenCV视频捕获对象
+    std::unique_ptr<FramePrefetcher> m_prefetcher;  ///< 当前输入源的预取解码线程
+    std::unique_ptr<FramePrefetcher> m_nextPrefetcher;  ///< 播放列表中的下一个文件，已提前打开并预取
+    int m_prefetchFrames = 4;   ///< 预取帧数
+    bool m_nativeYuv = false;   ///< 请求解码器直接输出平面YUV（QSettings `Reader/native_yuv`）
+    double m_imageFps = 25.0;   ///< 图像序列播放帧率，<=0 表示不按时间播放
+    int m_imageDecodeAhead = 4; ///< 图像序列在线程池中并行解码的张数
     int m_frameInterval = 33;   ///< 帧间隔(毫秒)，默认33ms约30fps
     QTimer *m_timer;            ///< 定时器，用于控制帧读取频率
     int m_frameCounter = 0;     ///< 帧计数器，用于减少debug输出频率
+    FrameCreditPool *m_creditPool = nullptr;  ///< 处理端信用池
+    bool m_maxThroughput = false;       ///< 最大吞吐模式
+    bool m_waitingForCredit = false;    ///< 最大吞吐模式下因处理端饱和而暂停定时器
+    bool m_waitingForFrame = false;     ///< 最大吞吐模式下因预取缓冲为空而暂停定时器
+    quint64 m_skippedFrames = 0;        ///< 跳过解码的帧数
+    QElapsedTimer m_playClock;          ///< 播放时钟（单调）
+    qint64 m_mediaAnchorMs = -1;        ///< 播放时钟零点对应的媒体时间，<0 表示下一帧重新对齐
+    qint64 m_driftMs = 0;               ///< 最近发送帧的延迟
+    qint64 m_maxDriftMs = 0;            ///< 最大延迟
+    quint64 m_lateFrames = 0;           ///< 取帧时丢弃的过期帧数
+    quint64 m_lateFramesRetired = 0;    ///< 已销毁的预取线程丢弃的过期帧数
+    bool m_previewPending = false;      ///< 暂停时定位后等待显示一帧
+    
+    /**
+     * @brief 当前应使用的定时器间隔（最大吞吐模式下文件源为0）
+     */
+    int currentInterval() const;
     
     /**
-     * @brief 打开输入源（文件或摄像头）
+     * @brief 是否为按时间戳播放的非实时源（视频文件或图像序列）
+     */
+    bool isRecordedSource() const;
+    
+    /**
+     * @brief 打开输入源（文件、摄像头或图像序列），启动预取解码线程
      */
     bool openSource();
+    
+    /**
+     * @brief 创建视频文件输入源（解码帧缓存开启时包装为 CachedFrameSource）
+     */
+    std::unique_ptr<FrameSource> createFileSource(const QString &path) const;
+    
+    /**
+     * @brief 让预取线程为当前输入源服务：按播放方式设置跳帧，并在有新帧时通知
+     */
+    void activatePrefetcher();
+    
+    /**
+     * @brief 停止并异步销毁当前（以及提前打开的下一个）预取解码线程
+     */
+    void retirePrefetcher();
+    
+    /**
+     * @brief 停止并异步销毁一个预取解码线程，不等待
+     */
+    void retire(std::unique_ptr<FramePrefetcher> &prefetcher);
+    
+    /**
+     * @brief 在后台打开播放列表中的下一个文件并预取
+     */
+    void preloadNext();
+    
+    /**
+     * @brief 切换到播放列表中的下一个文件，已是最后一个时返回false
+     */
+    bool advancePlaylist();
+    
+    /**
+     * @brief 定位或拖动预览
+     */
+    void seekTo(qint64 timestampMs, bool keyframeOnly);
+    
+    /**
+     * @brief 包装成共享帧发送，并报告播放位置
+     */
+    void emitFrame(const PrefetchedFrame& prefetched);
+    
+    /**
+     * @brief 当前播放时钟对应的媒体时间，未对齐时以 firstTimestampMs 为零点
+     */
+    qint64 mediaClock(qint64 firstTimestampMs);
 };
\ No newline at end of file
@@ -0,0 +1,303 @@
+#include "algorithmchain.h"
+#include "Algorithms/algorithmfactory.h"
+#include "stripexecutor.h"
+#include "sharedprefixcache.h"
+#include <QDebug>
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+// 缩小到目标尺寸：每级 pyrDown 缩小一半，剩余比例用 INTER_AREA，两者都有SIMD实现
+cv::Mat downscaleTo(const cv::Mat& src, const cv::Size& size)
+{
+    cv::Mat current = src;
+    while (current.cols / 2 >= size.width && current.rows / 2 >= size.height) {
+        cv::Mat half;
+        cv::pyrDown(current, half);
+        current = half;
+    }
+    if (current.size() == size) {
+        return current;
+    }
+    cv::Mat result;
+    cv::resize(current, result, size, 0, 0, cv::INTER_AREA);
+    return result;
+}
+
+} // namespace
+
+AlgorithmChain::~AlgorithmChain()
+{
+    releasePrefixSignatures();
+}
+
+void AlgorithmChain::enablePrefixSharing(SharedPrefixCache* cache, const void* owner)
+{
+    releasePrefixSignatures();
+    m_prefixCache = cache;
+    m_prefixOwner = owner;
+    if (m_prefixCache) {
+        for (quint64 signature : m_prefixSignatures) {
+            m_prefixCache->retain(m_prefixOwner, signature);
+        }
+    }
+}
+
+void AlgorithmChain::releasePrefixSignatures()
+{
+    if (m_prefixCache) {
+        for (quint64 signature : m_prefixSignatures) {
+            m_prefixCache->release(m_prefixOwner, signature);
+        }
+    }
+}
+
+void AlgorithmChain::sync(const AlgorithmChainSnapshot& snapshot)
+{
+    std::vector<Stage> stages;
+    stages.reserve(snapshot.entries.size());
+    
+    // 开头连续无状态阶段的累积签名，遇到有状态或创建失败的阶段即停止
+    std::vector<quint64> signatures;
+    // 工作分辨率不同的链中间结果不同，签名以工作分辨率为种子
+    quint64 signature = 0;
+    if (m_workingHeight > 0) {
+        signature = SharedPrefixCache::chainSignature(0, -1, QVariantMap{{"working_height", m_workingHeight}});
+    }
+    bool prefixOpen = true;
+    
+    for (const AlgorithmSnapshotEntry& entry : snapshot.entries) {
+        // 查找可复用的实例（条目标识与算法ID都一致）
+        auto it = std::find_if(m_stages.begin(), m_stages.end(), [&entry](const Stage& stage) {
+            return stage.algorithm && stage.key == entry.key && stage.algorithmId == entry.algorithmId;
+        });
+        
+        Stage stage;
+        if (it != m_stages.end()) {
+            stage = std::move(*it);
+        } else {
+            stage.key = entry.key;
+            stage.algorithmId = entry.algorithmId;
+            stage.algorithm.reset(AlgorithmFactory::instance().createAlgorithm(entry.algorithmId));
+            if (!stage.algorithm) {
+                qWarning() << "[AlgorithmChain] 无法创建算法实例, id =" << entry.algorithmId;
+                prefixOpen = false;
+                continue;
+            }
+        }
+        
+        // 只有参数版本变化时才下发参数，避免重复初始化
+        if (stage.paramsVersion != entry.paramsVersion) {
+            stage.algorithm->setParameters(entry.params);
+            stage.paramsVersion = entry.paramsVersion;
+        }
+        
+        stages.push_back(std::move(stage));
+        
+        if (prefixOpen && !entry.stateful) {
+            signature = SharedPrefixCache::chainSignature(signature, entry.algorithmId, entry.params);
+            signatures.push_back(signature);
+        } else {
+            prefixOpen = false;
+        }
+    }
+    
+    // 未被复用的旧实例随 m_stages 一起释放
+    m_stages = std::move(stages);
+    m_revision = snapshot.revision;
+    
+    // 先登记新签名再注销旧签名，避免未变化的前缀短暂变为非共享
+    if (m_prefixCache) {
+        for (quint64 sig : signatures) {
+            m_prefixCache->retain(m_prefixOwner, sig);
+        }
+    }
+    releasePrefixSignatures();
+    m_prefixSignatures = std::move(signatures);
+}
+
+void AlgorithmChain::setWorkingHeight(int rows)
+{
+    rows = qMax(0, rows);
+    if (rows == m_workingHeight) {
+        return;
+    }
+    m_workingHeight = rows;
+    // 前缀签名依赖工作分辨率：强制下一次处理前重新同步
+    m_revision = std::numeric_limits<quint64>::max();
+}
+
+WorkingImage AlgorithmChain::ingest(const cv::Mat& input) const
+{
+    WorkingImage image;
+    image.image = input;
+    image.workingSize = input.size();
+    if (m_workingHeight <= 0 || input.empty() || input.rows <= m_workingHeight) {
+        return image;
+    }
+    
+    // 只在进入链时缩小一次，原图保留为全分辨率上下文
+    image.scale = static_cast<double>(input.rows) / m_workingHeight;
+    image.workingSize = cv::Size(qMax(1, cvRound(input.cols / image.scale)), m_workingHeight);
+    image.display = input;
+    image.image = downscaleTo(input, image.workingSize);
+    return image;
+}
+
+void AlgorithmChain::expandLuma(WorkingImage& image)
+{
+    ensureWorkingImage(image);
+    if (image.image.channels() == 1) {
+        cv::Mat bgr;
+        cv::cvtColor(image.image, bgr, cv::COLOR_GRAY2BGR);
+        image.image = bgr;
+    }
+    image.display.release();
+    image.luma = false;
+}
+
+void AlgorithmChain::ensureWorkingImage(WorkingImage& image)
+{
+    // 检测类阶段只输出全分辨率结果，后续阶段需要时再缩小
+    if (image.image.empty() && !image.display.empty()) {
+        image.image = downscaleTo(image.display, image.workingSize);
+    }
+}
+
+cv::Mat AlgorithmChain::process(const cv::Mat& input)
+{
+    WorkingImage image = ingest(input);
+    processFrom(0, image);
+    return image.output();
+}
+
+cv::Mat AlgorithmChain::process(const SharedFrame& frame)
+{
+    return processWorking(frame).output();
+}
+
+void AlgorithmChain::processWorking(WorkingImage& image)
+{
+    processFrom(0, image);
+}
+
+WorkingImage AlgorithmChain::processWorking(const SharedFrame& frame)
+{
+    // 链首只需要亮度时直接取亮度平面：YUV 帧零拷贝，BGR 帧的灰度转换也随帧共享
+    const bool lumaInput = !m_stages.empty() && m_stages.front().algorithm->isLumaOnly()
+                           && (frame.hasNativeLuma() || frame.image().channels() > 1);
+    const cv::Mat& input = lumaInput ? frame.luma() : frame.image();
+    WorkingImage image = ingest(input);
+    image.luma = lumaInput;
+    if (!m_prefixCache) {
+        processFrom(0, image);
+        return image;
+    }
+    
+    // 逐级查找共享前缀：较长前缀被共享时较短前缀必然也被共享，遇到非共享即可停止
+    size_t next = 0;
+    for (; next < m_prefixSignatures.size(); ++next) {
+        const quint64 signature = m_prefixSignatures[next];
+        if (!m_prefixCache->isShared(signature)) {
+            break;
+        }
+        
+        cv::Mat cached;
+        cv::Mat cachedDisplay;
+        if (m_prefixCache->acquire(input, frame.sequence(), signature, cached, &cachedDisplay)) {
+            image.image = cached;
+            image.display = cachedDisplay;
+            image.luma = image.luma && m_stages[next].algorithm->isLumaOnly();
+            continue;
+        }
+        
+        // 已认领：计算本级并发布，失败时放弃认领让其它视图自行计算
+        try {
+            runStage(next, image);
+        } catch (...) {
+            m_prefixCache->publish(input, frame.sequence(), signature, cv::Mat());
+            throw;
+        }
+        m_prefixCache->publish(input, frame.sequence(), signature, image.image, image.display);
+    }
+    
+    processFrom(next, image);
+    return image;
+}
+
+void AlgorithmChain::runStage(size_t index, WorkingImage& image)
+{
+    Algorithm* algorithm = m_stages[index].algorithm.get();
+    if (image.luma && !algorithm->isLumaOnly()) {
+        expandLuma(image);
+    }
+    
+    // 在工作分辨率上检测，结果画回全分辨率
+    if (image.scale != 1.0 && !image.display.empty() && algorithm->supportsScaledAnalysis()) {
+        ensureWorkingImage(image);
+        image.display = algorithm->processScaled(image.image, image.display, image.scale);
+        image.image.release();
+        return;
+    }
+    
+    ensureWorkingImage(image);
+    const int radius = algorithm->kernelRadius();
+    if (radius >= 0 && StripExecutor::shouldSplit(image.image, radius)) {
+        image.image = StripExecutor::run(image.image, radius, [algorithm](const cv::Mat& strip) {
+            return algorithm->process(strip);
+        });
+    } else {
+        image.image = algorithm->process(image.image);
+    }
+    // 像素已改变，全分辨率上下文失效
+    image.display.release();
+}
+
+void AlgorithmChain::processFrom(size_t first, WorkingImage& image)
+{
+    const size_t count = m_stages.size();
+    size_t i = first;
+    while (i < count) {
+        // 收集连续的可分条阶段，整段一起分条以减少拼接次数，重叠半径累加
+        size_t end = i;
+        int radius = 0;
+        while (end < count) {
+            const int r = m_stages[end].algorithm->kernelRadius();
+            if (r < 0 || (image.luma && !m_stages[end].algorithm->isLumaOnly())) {
+                break;
+            }
+            radius += r;
+            ++end;
+        }
+        
+        if (end <= i + 1) {
+            runStage(i, image);
+            ++i;
+            continue;
+        }
+        
+        auto runSpan = [this, i, end](const cv::Mat& input) {
+            cv::Mat out = input;
+            for (size_t k = i; k < end; ++k) {
+                out = m_stages[k].algorithm->process(out);
+            }
+            return out;
+        };
+        
+        ensureWorkingImage(image);
+        image.image = StripExecutor::shouldSplit(image.image, radius)
+                ? StripExecutor::run(image.image, radius, runSpan)
+                : runSpan(image.image);
+        image.display.release();
+        i = end;
+    }
+}
+
+void AlgorithmChain::clear()
+{
+    releasePrefixSignatures();
+    m_prefixSignatures.clear();
+    m_stages.clear();
+    m_revision = 0;
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "algorithmlistmodel.h"
+#include "sharedframe.h"
+#include "Algorithms/algorithm.h"
+
+class SharedPrefixCache;
+
+/**
+ * @brief 工作分辨率下的中间结果
+ *
+ * 开启工作分辨率后，帧在进入算法链时缩小一次，之后的阶段都在小图上运行。
+ * 只要还没有阶段改变过像素，display 就保存对应的全分辨率图像，
+ * 检测类算法据此把检测结果画回全分辨率。
+ */
+struct WorkingImage {
+    cv::Mat image;          ///< 当前结果（工作分辨率）；display 有效时可能为空，按需缩小
+    cv::Mat display;        ///< 与 image 对应的全分辨率图像，未缩小或像素已被改变时为空
+    cv::Size workingSize;   ///< 工作分辨率
+    double scale = 1.0;     ///< 全分辨率与工作分辨率的尺寸比
+    bool luma = false;      ///< image 是彩色帧的亮度结果，遇到需要彩色的阶段前展开为三通道
+
+    /**
+     * @brief 最终输出：有全分辨率结果时输出全分辨率
+     */
+    const cv::Mat& output() const { return display.empty() ? image : display; }
+};
+
+/**
+ * @class AlgorithmChain
+ * @brief 处理线程持有的长期算法实例链
+ *
+ * 通过 AlgorithmListModel 的快照同步：已有条目复用原实例（保留级联分类器、
+ * 背景模型、上一帧等状态），只为新增条目创建实例，只在参数版本变化时下发参数。
+ * 不是线程安全的，只能由单个处理线程使用。
+ */
+class AlgorithmChain {
+public:
+    AlgorithmChain() = default;
+    ~AlgorithmChain();
+    
+    AlgorithmChain(const AlgorithmChain&) = delete;
+    AlgorithmChain& operator=(const AlgorithmChain&) = delete;
+    
+    /**
+     * @brief 按快照同步算法实例
+     */
+    void sync(const AlgorithmChainSnapshot& snapshot);
+    
+    /**
+     * @brief 启用跨视图公共前缀共享
+     * @param cache 前缀缓存
+     * @param owner 所属视图的标识，同一视图的多个副本使用同一标识
+     */
+    void enablePrefixSharing(SharedPrefixCache* cache, const void* owner);
+    
+    /**
+     * @brief 设置工作分辨率（帧高度），0表示按原始分辨率处理
+     *
+     * 修改后签名需要重新计算，下一次处理前会重新同步快照。
+     */
+    void setWorkingHeight(int rows);
+    int workingHeight() const { return m_workingHeight; }
+    
+    /**
+     * @brief 按工作分辨率缩小输入帧（先逐级 pyrDown，再 INTER_AREA 缩放到目标尺寸）
+     */
+    WorkingImage ingest(const cv::Mat& input) const;
+    
+    /**
+     * @brief 当前已同步到的模型修订号
+     */
+    quint64 revision() const { return m_revision; }
+    
+    /**
+     * @brief 依次应用链中所有算法
+     *
+     * 连续的可分条算法（kernelRadius() >= 0）在大帧上按横条并行执行。
+     */
+    cv::Mat process(const cv::Mat& input);
+    
+    /**
+     * @brief 处理一帧；启用前缀共享时，开头的无状态阶段优先取用其它视图已算好的结果
+     */
+    cv::Mat process(const SharedFrame& frame);
+    
+    /**
+     * @brief 按工作分辨率处理一帧，保留全分辨率上下文供流水线后续阶段使用
+     *
+     * 链首为只依赖亮度的算法时以 SharedFrame::luma() 为输入，YUV 帧不再转换为BGR。
+     */
+    WorkingImage processWorking(const SharedFrame& frame);
+    
+    /**
+     * @brief 继续处理已缩小的中间结果（流水线后续阶段，不再缩小）
+     */
+    void processWorking(WorkingImage& image);
+    
+    int size() const { return static_cast<int>(m_stages.size()); }
+    bool isEmpty() const { return m_stages.empty(); }
+    
+    /**
+     * @brief 释放所有实例
+     */
+    void clear();
+    
+private:
+    // 从第 first 个阶段开始处理
+    void processFrom(size_t first, WorkingImage& image);
+    
+    // 执行单个阶段，大帧且可分条时分条并行；检测类阶段在有全分辨率上下文时把结果画回全分辨率
+    void runStage(size_t index, WorkingImage& image);
+    
+    // 确保工作分辨率图像可用
+    static void ensureWorkingImage(WorkingImage& image);
+    
+    // 亮度结果交给需要彩色的阶段前转回三通道，与各算法对三通道输入的输出一致
+    static void expandLuma(WorkingImage& image);
+    
+    // 注销当前登记的前缀签名
+    void releasePrefixSignatures();
+    
+    struct Stage {
+        quint64 key = 0;
+        int algorithmId = -1;
+        quint64 paramsVersion = 0;
+        std::unique_ptr<Algorithm> algorithm;
+    };
+    
+    std::vector<Stage> m_stages;
+    quint64 m_revision = 0;
+    
+    SharedPrefixCache* m_prefixCache = nullptr;
+    const void* m_prefixOwner = nullptr;
+    std::vector<quint64> m_prefixSignatures;    // 开头各无状态阶段的累积签名
+    int m_workingHeight = 0;                    // 工作分辨率（帧高度），0为原始分辨率
+};
@@ -12,6 +12,9 @@ AlgorithmListModel::~AlgorithmListModel()
     QWriteLocker locker(&m_lock);
     qDeleteAll(m_algorithms);
     m_algorithms.clear();
+    m_entryKeys.clear();
+    m_paramsVersions.clear();
+    m_lastUpdates.clear();
 }
 
 int AlgorithmListModel::rowCount(const QModelIndex &parent) const
@@ -89,7 +92,12 @@ bool AlgorithmListModel::setData(const QModelIndex &index, const QVariant &value
     
     // 仅支持更新参数
     if (role == ParamsRole && value.canConvert<QVariantMap>()) {
-        algorithm->setParameters(value.toMap());
+        const QVariantMap params = value.toMap();
+        algorithm->setParameters(params);
+        m_lastUpdates[index.row()] = params;
+        m_paramsVersions[index.row()]++;
+        bumpRevision();
+        locker.unlock();
         emit dataChanged(index, index, {role});
         return true;
     }
@@ -122,6 +130,10 @@ void AlgorithmListModel::addAlgorithm(int algorithmId, const QString &name, cons
     {
         QWriteLocker writeLock(&m_lock);
         m_algorithms.append(algorithm);
+        m_entryKeys.append(m_nextEntryKey++);
+        m_paramsVersions.append(1);
+        m_lastUpdates.append(params);
+        bumpRevision();
     }
     
     // 结束插入
@@ -140,6 +152,10 @@ bool AlgorithmListModel::removeAlgorithm(int index)
     // 删除算法对象并从列表中移除
     delete m_algorithms[index];
     m_algorithms.removeAt(index);
+    m_entryKeys.removeAt(index);
+    m_paramsVersions.removeAt(index);
+    m_lastUpdates.removeAt(index);
+    bumpRevision();
     
     endRemoveRows();
     return true;
@@ -157,6 +173,10 @@ void AlgorithmListModel::clearAlgorithms()
     // 删除所有算法对象
     qDeleteAll(m_algorithms);
     m_algorithms.clear();
+    m_entryKeys.clear();
+    m_paramsVersions.clear();
+    m_lastUpdates.clear();
+    bumpRevision();
     
     endResetModel();
 }
@@ -201,11 +221,10 @@ bool AlgorithmListModel::updateAlgorithmParameters(int index, const QVariantMap
         return false;
     }
     
-    Algorithm* algorithm = nullptr;
     QModelIndex modelIndex;
     
-    {
-        // 缩小锁的范围，只在必要时锁定
+    try {
+        // 参数更新在写锁内完成，保证快照读取到的参数与版本号一致
         QWriteLocker locker(&m_lock);
         
         if (index >= m_algorithms.size() || !m_algorithms[index]) {
@@ -213,19 +232,12 @@ bool AlgorithmListModel::updateAlgorithmParameters(int index, const QVariantMap
             return false;
         }
         
-        // 获取算法指针
-        algorithm = m_algorithms[index];
+        m_algorithms[index]->setParameters(parameters);
+        m_lastUpdates[index] = parameters;
+        m_paramsVersions[index]++;
+        bumpRevision();
         modelIndex = createIndex(index, 0);
     }
-    
-    // 锁外更新参数
-    try {
-        algorithm->setParameters(parameters);
-        
-        // 发送数据变更信号
-        emit dataChanged(modelIndex, modelIndex, {ParamsRole});
-        return true;
-    }
     catch (const std::exception& e) {
         qWarning() << "[CPP-ERROR] 更新参数时发生异常:" << e.what();
         return false;
@@ -234,6 +246,10 @@ bool AlgorithmListModel::updateAlgorithmParameters(int index, const QVariantMap
         qWarning() << "[CPP-ERROR] 更新参数时发生未知异常";
         return false;
     }
+    
+    // 锁外发送数据变更信号
+    emit dataChanged(modelIndex, modelIndex, {ParamsRole});
+    return true;
 }
 
 QVector<Algorithm*> AlgorithmListModel::getAllAlgorithms() const
@@ -256,6 +272,37 @@ QVector<Algorithm*> AlgorithmListModel::getAllAlgorithms() const
     return result;
 }
 
+AlgorithmChainSnapshot AlgorithmListModel::snapshot() const
+{
+    AlgorithmChainSnapshot result;
+    
+    QReadLocker locker(&m_lock);
+    result.revision = m_revision.load(std::memory_order_acquire);
+    result.entries.reserve(m_algorithms.size());
+    
+    for (int i = 0; i < m_algorithms.size(); ++i) {
+        if (!m_algorithms[i]) {
+            continue;
+        }
+        
+        AlgorithmSnapshotEntry entry;
+        entry.key = m_entryKeys[i];
+        entry.algorithmId = m_algorithms[i]->getId();
+        entry.paramsVersion = m_paramsVersions[i];
+        entry.stateful = m_algorithms[i]->isStateful();
+        
+        // 完整参数 + 最近一次下发的参数，保证reset等一次性动作也能传到处理线程
+        entry.params = m_algorithms[i]->getParameters();
+        for (auto it = m_lastUpdates[i].cbegin(); it != m_lastUpdates[i].cend(); ++it) {
+            entry.params.insert(it.key(), it.value());
+        }
+        
+        result.entries.append(entry);
+    }
+    
+    return result;
+}
+
 QVariantMap AlgorithmListModel::getAlgorithmInfo(int index) const
 {
     QVariantMap info;
@@ -5,8 +5,32 @@
 #include <QVector>
 #include <QReadWriteLock>
 #include <QListView>
+#include <atomic>
 #include "Algorithms/algorithm.h" // 必须包含此头文件
 
+// 算法链快照中的单个算法条目
+struct AlgorithmSnapshotEntry {
+    quint64 key = 0;            // 条目的稳定标识（增删其它算法时不变）
+    int algorithmId = -1;       // 算法ID
+    QVariantMap params;         // 需要下发给处理线程实例的参数
+    quint64 paramsVersion = 0;  // 参数版本，每次修改参数递增
+    bool stateful = false;      // 算法是否依赖之前的帧
+};
+
+// 算法链快照：处理线程据此同步自己持有的长期算法实例
+struct AlgorithmChainSnapshot {
+    quint64 revision = 0;                   // 模型修订号
+    QVector<AlgorithmSnapshotEntry> entries;
+    
+    // 链中是否含有有状态算法
+    bool hasStatefulStage() const {
+        for (const AlgorithmSnapshotEntry& entry : entries) {
+            if (entry.stateful) return true;
+        }
+        return false;
+    }
+};
+
 class AlgorithmListModel : public QAbstractListModel
 {
     Q_OBJECT
@@ -48,9 +72,15 @@ public:
     // 更新算法参数
    // bool updateAlgorithmParams(int row, const QVariantMap &params);
     
-    // 获取所有算法 - 修改返回类型
+    // 获取所有算法的克隆（调用方负责释放，用于导出等一次性场景）
     QVector<Algorithm*> getAllAlgorithms() const;
     
+    // 模型修订号：任何增删或参数修改都会递增（无锁读取）
+    quint64 revision() const { return m_revision.load(std::memory_order_acquire); }
+    
+    // 获取算法链快照（ID + 参数 + 版本），不克隆算法对象
+    AlgorithmChainSnapshot snapshot() const;
+    
     // QML可调用的安全方法
     Q_INVOKABLE QVariantMap getAlgorithmInfo(int index) const;
     Q_INVOKABLE bool updateAlgorithmParameters(int index, const QVariantMap &parameters);
@@ -58,5 +88,13 @@ public:
 private:
     // 直接存储算法指针，不再使用结构体
     QVector<Algorithm*> m_algorithms;   // 算法列表
+    QVector<quint64> m_entryKeys;       // 与m_algorithms一一对应的条目标识
+    QVector<quint64> m_paramsVersions;  // 与m_algorithms一一对应的参数版本
+    QVector<QVariantMap> m_lastUpdates; // 最近一次下发的参数（含reset等一次性动作）
+    quint64 m_nextEntryKey = 1;         // 下一个条目标识
+    std::atomic<quint64> m_revision{0}; // 模型修订号
     mutable QReadWriteLock m_lock;      // 读写锁
+    
+    // 在持有写锁时调用，递增修订号
+    void bumpRevision() { m_revision.fetch_add(1, std::memory_order_release); }
 };
\ No newline at end of file
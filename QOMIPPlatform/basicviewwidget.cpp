@@ -2,11 +2,15 @@
 #include "ui_basicviewwidget.h"
 #include "CommonUtils.h"
 #include "algorithmdialog.h"
-#include <QGraphicsView>
-#include <QWheelEvent>
-#include <QMouseEvent>
+#include "taskscheduler.h"
 #include <QMenu> // 添加此头文件
 #include <QContextMenuEvent> // 可能也需要添加
+#include <QFileDialog>
+#include <QInputDialog>
+#include <QActionGroup>
+#include <QDebug>
+#include <QScreen>
+#include <QSettings>
 
 BasicViewWidget::BasicViewWidget(QWidget *parent)
     : QWidget(parent)
@@ -15,20 +19,20 @@ BasicViewWidget::BasicViewWidget(QWidget *parent)
 {
     ui->setupUi(this);
 
-    /* 把场景挂到 view */
-    ui->graphicsView->setScene(&m_scene);
-
-    /* 拖拽 / 滚轮 由 view 自己完成 */
-    ui->graphicsView->setDragMode(QGraphicsView::ScrollHandDrag);
-    ui->graphicsView->setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
-    ui->graphicsView->setResizeAnchor(QGraphicsView::AnchorUnderMouse);
-
-    /* 把 pixmapItem 放进场景 */
-    m_scene.addItem(&m_pixItem);
+    /* 拖拽 / 滚轮 / 双击还原 由画布自己完成 */
     
-    /* 连接处理器信号 */
+    /* 显示节奏：跟随屏幕刷新率，或 QSettings `Scheduler/display_fps` 设定的上限 */
+    QSettings settings("QOMIPPlatform", "Scheduler");
+    m_displayFpsCap = qMax(0, settings.value("display_fps", 0).toInt());
+    m_presentTimer = new QTimer(this);
+    m_presentTimer->setSingleShot(true);
+    m_presentTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_presentTimer, &QTimer::timeout, this, &BasicViewWidget::convertPending);
+    m_lastPresent.start();
+    
+    /* 连接处理器信号：在处理线程中直接放入显示邮箱，不为每帧排队GUI事件 */
     connect(m_processor, &FrameProcessor::frameProcessed,
-            this, &BasicViewWidget::onFrameProcessed);
+            this, &BasicViewWidget::onFrameProcessed, Qt::DirectConnection);
     
     /* 启动处理器 */
     m_processor->startProcessing();
@@ -43,15 +47,22 @@ BasicViewWidget::~BasicViewWidget()
         delete m_processor;
         m_processor = nullptr;
     }
+    
+    // 等待正在进行的显示转换结束，它还在使用画布
+    {
+        QMutexLocker locker(&m_displayMutex);
+        m_closing = true;
+        while (m_converting) {
+            m_convertDone.wait(&m_displayMutex);
+        }
+    }
     delete ui; 
 }
 
 void BasicViewWidget::setImage(const cv::Mat &img)
 {
     if (img.empty()) return;
-    m_pixItem.setPixmap(CU::matToPixmap(img,false));
-    ui->graphicsView->fitInView(&m_pixItem, Qt::KeepAspectRatio);
-    //m_scale = 1.0;
+    ui->canvas->setSource(img);   // 与播放路径一样在工作线程中转换
 }
 
 // void BasicViewWidget::setAlgorithmType(int type)
@@ -59,37 +70,146 @@ void BasicViewWidget::setImage(const cv::Mat &img)
 //     m_processor->setAlgorithmType(type);
 // }
 
-void BasicViewWidget::processFrame(const cv::Mat& frame)
+void BasicViewWidget::processFrame(const SharedFrame& frame)
 {
     if (!frame.empty()) {
         m_processor->enqueueFrame(frame);
     }
 }
 
-void BasicViewWidget::onFrameProcessed(const cv::Mat& result)
+void BasicViewWidget::onFrameProcessed(const SharedFrame& result)
+{
+    // 在处理线程中调用：只替换邮箱中的结果，转换在每个显示周期对最新结果进行一次
+    QMutexLocker locker(&m_displayMutex);
+    if (!m_pendingFrame.isNull()) {
+        ++m_displayStats.unshown;   // 还没显示就被更新的结果取代
+    }
+    m_pendingFrame = result;
+    if (!m_presentScheduled) {
+        m_presentScheduled = true;
+        QMetaObject::invokeMethod(this, "schedulePresent", Qt::QueuedConnection);
+    }
+}
+
+void BasicViewWidget::schedulePresent()
+{
+    // 距上次绘制不足一个显示周期时等到下个周期，其间到达的结果只保留最新的
+    const qint64 wait = presentInterval() - m_lastPresent.elapsed();
+    m_presentTimer->start(static_cast<int>(qMax<qint64>(0, wait)));
+}
+
+int BasicViewWidget::presentInterval() const
 {
-    // 存储当前处理后的帧用于导出
-    result.copyTo(m_currentFrame);
-    setImage(result);
+    // 按当前所在屏幕的刷新率，窗口移动到其它屏幕后自动跟随
+    const QScreen *current = screen();
+    double fps = current && current->refreshRate() > 0.0 ? current->refreshRate() : 60.0;
+    if (m_displayFpsCap > 0) {
+        fps = qMin<double>(fps, m_displayFpsCap);
+    }
+    return qMax(1, qRound(1000.0 / fps));
+}
+
+void BasicViewWidget::convertPending()
+{
+    // 显示周期到了：在调度器的工作线程中转换邮箱中最新的结果，GUI线程不转换像素
+    {
+        QMutexLocker locker(&m_displayMutex);
+        if (m_pendingFrame.isNull() || m_closing) {
+            m_presentScheduled = false;
+            return;
+        }
+        m_converting = true;
+    }
+    TaskScheduler::instance().submit([this]() {
+        QMutexLocker locker(&m_displayMutex);
+        const SharedFrame result = m_pendingFrame;
+        m_pendingFrame = SharedFrame();
+        if (!m_closing && !result.isNull()) {
+            // 转换期间不持有邮箱锁，处理线程可以继续放入新结果
+            locker.unlock();
+            FrameCanvas::Prepared image;
+            bool converted = true;
+            try {
+                image = ui->canvas->prepareImage(result.image());
+            } catch (const std::exception& e) {
+                qWarning() << "[BasicViewWidget] 显示转换失败:" << e.what();
+                converted = false;
+            } catch (...) {
+                qWarning() << "[BasicViewWidget] 显示转换失败";
+                converted = false;
+            }
+            locker.relock();
+            if (!m_closing) {
+                if (converted) {
+                    QMetaObject::invokeMethod(this, [this, result, image]() {
+                        presentFrame(result, image);
+                    }, Qt::QueuedConnection);
+                } else {
+                    // 丢弃这一帧；转换期间到达的新结果不会再自己安排显示，由这里安排
+                    m_presentScheduled = !m_pendingFrame.isNull();
+                    if (m_presentScheduled) {
+                        QMetaObject::invokeMethod(this, "schedulePresent", Qt::QueuedConnection);
+                    }
+                }
+            }
+        }
+        // 无论转换是否成功都要清除，析构函数在等待它
+        m_converting = false;
+        m_convertDone.wakeAll();
+    });
+}
+
+void BasicViewWidget::presentFrame(const SharedFrame &result, const FrameCanvas::Prepared &image)
+{
+    quint64 presented = 0;
+    quint64 unshown = 0;
+    {
+        QMutexLocker locker(&m_displayMutex);
+        presented = ++m_displayStats.presented;
+        unshown = m_displayStats.unshown;
+        
+        // 转换期间又到了新结果：安排下一个显示周期
+        m_presentScheduled = !m_pendingFrame.isNull();
+    }
+    m_lastPresent.restart();
+    if (m_presentScheduled) {
+        schedulePresent();
+    }
+    
+    // 存储当前处理后的帧用于导出（结果帧不可变，只保留引用）
+    m_currentFrame = result.image();
+    ui->canvas->setImage(image);
+    
+    // 实时源的帧带有采集时刻，统计采集到显示的延迟
+    if (result.captureTimeUs() >= 0) {
+        recordLatency(SharedFrame::monotonicUs() - result.captureTimeUs());
+    }
+    
+    if (presented % 300 == 0) {
+        qDebug() << "[BasicViewWidget]" << getWidgetName() << "presented" << presented
+                 << "frames, unshown" << unshown;
+    }
 }
 
-/* 滚轮缩放 */
-void BasicViewWidget::wheelEvent(QWheelEvent *e)
+BasicViewWidget::DisplayStats BasicViewWidget::displayStats() const
 {
-    const double factor = 1.15;
-    if (e->angleDelta().y() > 0)
-        m_scale *= factor;
-    else
-        m_scale /= factor;
-    ui->graphicsView->resetTransform();
-    ui->graphicsView->scale(m_scale, m_scale);
+    QMutexLocker locker(&m_displayMutex);
+    return m_displayStats;
 }
 
-/* 双击还原 */
-void BasicViewWidget::mouseDoubleClickEvent(QMouseEvent *)
+void BasicViewWidget::recordLatency(qint64 latencyUs)
 {
-    ui->graphicsView->fitInView(&m_pixItem, Qt::KeepAspectRatio);
-    m_scale = 1.0;
+    m_latency.lastUs = latencyUs;
+    m_latency.averageUs = m_latency.averageUs < 0
+        ? latencyUs : m_latency.averageUs + (latencyUs - m_latency.averageUs) / 16;
+    m_latency.maxUs = qMax(m_latency.maxUs, latencyUs);
+    
+    // 每100帧输出一次，最大值按窗口重新统计
+    if (++m_latency.frames % 100 == 0) {
+        qDebug() << "[BasicViewWidget]" << getWidgetName() << "capture-to-display latency avg"
+                 << m_latency.averageUs / 1000.0 << "ms, max" << m_latency.maxUs / 1000.0 << "ms";
+        m_latency.maxUs = 0;
+    }
 }
 
 void BasicViewWidget::contextMenuEvent(QContextMenuEvent *event)
@@ -99,17 +219,84 @@ void BasicViewWidget::contextMenuEvent(QContextMenuEvent *event)
     // 添加算法管理菜单项
     QAction *algorithmAction = menu.addAction("算法管理");
     connect(algorithmAction, &QAction::triggered, this, &BasicViewWidget::showAlgorithmManager);
-    
+
+    // 流水线模式：算法链按阶段拆分，各阶段同时处理不同的帧
+    QAction *pipelineAction = menu.addAction("流水线模式");
+    pipelineAction->setCheckable(true);
+    pipelineAction->setChecked(m_processor->executionMode() == ExecutionMode::StagePipelined);
+    connect(pipelineAction, &QAction::toggled, [this](bool checked) {
+        m_processor->setExecutionMode(checked ? ExecutionMode::StagePipelined
+                                              : ExecutionMode::FrameParallel);
+    });
+
+    // 工作分辨率：帧进入算法链时缩小一次，检测结果仍画在全分辨率帧上
+    QMenu *resolutionMenu = menu.addMenu("工作分辨率");
+    QActionGroup *resolutionGroup = new QActionGroup(resolutionMenu);
+    const QVector<QPair<QString, int>> resolutions = {
+        {"原始分辨率", 0}, {"1080p", 1080}, {"720p", 720}, {"540p", 540}, {"360p", 360}
+    };
+    for (const auto &resolution : resolutions) {
+        QAction *action = resolutionMenu->addAction(resolution.first);
+        action->setCheckable(true);
+        action->setChecked(m_processor->workingResolution() == resolution.second);
+        resolutionGroup->addAction(action);
+        const int rows = resolution.second;
+        connect(action, &QAction::triggered, [this, rows]() {
+            m_processor->setWorkingResolution(rows);
+        });
+    }
+
+    // 输入源：跟随主输入源，或绑定独立的文件/摄像头
+    addSourceMenu(&menu);
+
     // 可以添加其他菜单项...
     menu.addSeparator();
     QAction *resetAction = menu.addAction("重置视图");
-    connect(resetAction, &QAction::triggered, [this]() {
-        // 重置视图的代码
-    });
+    connect(resetAction, &QAction::triggered, ui->canvas, &FrameCanvas::resetView);
     
     menu.exec(event->globalPos());
 }
 
+void BasicViewWidget::addSourceMenu(QMenu *menu)
+{
+    QMenu *sourceMenu = menu->addMenu("输入源");
+    
+    QAction *mainAction = sourceMenu->addAction("主输入源");
+    mainAction->setCheckable(true);
+    mainAction->setChecked(m_boundSource.isNull());
+    connect(mainAction, &QAction::triggered, [this]() {
+        emit sourceChangeRequested(this, SourceSpec());
+    });
+    
+    if (!m_boundSource.isNull()) {
+        QAction *currentAction = sourceMenu->addAction(m_boundSource.displayName());
+        currentAction->setCheckable(true);
+        currentAction->setChecked(true);
+        currentAction->setEnabled(false);
+    }
+    
+    sourceMenu->addSeparator();
+    QAction *fileAction = sourceMenu->addAction("视频文件...");
+    connect(fileAction, &QAction::triggered, [this]() {
+        const QString file = QFileDialog::getOpenFileName(
+            this, "选择视频文件", QString(),
+            "视频文件 (*.mp4 *.avi *.mov *.wmv *.flv *.mkv *.webm *.m4v *.3gp *.mpg *.mpeg);;所有文件 (*)");
+        if (!file.isEmpty()) {
+            emit sourceChangeRequested(this, SourceSpec::file(file));
+        }
+    });
+    
+    QAction *cameraAction = sourceMenu->addAction("摄像头...");
+    connect(cameraAction, &QAction::triggered, [this]() {
+        bool ok = false;
+        const int index = QInputDialog::getInt(this, "选择摄像头", "摄像头索引:",
+                                               qMax(0, m_boundSource.cameraIndex), 0, 63, 1, &ok);
+        if (ok) {
+            emit sourceChangeRequested(this, SourceSpec::camera(index));
+        }
+    });
+}
+
 void BasicViewWidget::showAlgorithmManager()
 {
     // 创建并显示算法管理对话框
@@ -2,11 +2,15 @@
 #define BASICVIEWWIDGET_H
 
 #include <QWidget>
-#include <QGraphicsScene>
-#include <QGraphicsPixmapItem>
-#include <QWheelEvent>
+#include <QMenu>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QTimer>
+#include <QElapsedTimer>
 #include <opencv2/opencv.hpp>
 #include "frameprocessor.h"
+#include "decodeservice.h"
+#include "framecanvas.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class BasicViewWidget; }
@@ -16,17 +20,31 @@ class BasicViewWidget : public QWidget
 {
     Q_OBJECT
 public:
+    /* 采集到显示的延迟统计（只统计实时源的帧），单位微秒 */
+    struct LatencyStats {
+        qint64  lastUs = -1;     // 最近一帧
+        qint64  averageUs = -1;  // 滑动平均
+        qint64  maxUs = 0;       // 当前统计窗口（100帧）内的最大值
+        quint64 frames = 0;      // 已统计的帧数
+    };
+
+    /* 显示统计：处理结果中实际显示的帧和被更新结果取代、从未显示的帧 */
+    struct DisplayStats {
+        quint64 presented = 0;
+        quint64 unshown = 0;
+    };
+
     explicit BasicViewWidget(QWidget *parent = nullptr);
     ~BasicViewWidget();
 
-    /* 把 Mat 显示到场景里；如果场景里已经有图则替换 */
+    /* 把 Mat 显示到画布上；如果画布上已经有图则替换 */
     void setImage(const cv::Mat &img);
     
     /* 设置算法类型 */
     //void setAlgorithmType(int type);
     
     /* 处理新帧 */
-    void processFrame(const cv::Mat& frame);
+    void processFrame(const SharedFrame& frame);
     
     /* 获取当前显示的处理后图像 */
     cv::Mat getCurrentProcessedFrame() const;
@@ -36,10 +54,27 @@ public:
     
     /* 获取当前widget的算法列表（用于导出） */
     QVector<Algorithm*> getAlgorithms() const;
+    
+    /* 记录当前绑定的输入源（仅用于菜单显示），空表示跟随主输入源 */
+    void setBoundSource(const SourceSpec& source) { m_boundSource = source; }
+    const SourceSpec& boundSource() const { return m_boundSource; }
+    
+    /* 采集到显示的延迟：从采集线程 grab() 返回到处理结果设置到画面 */
+    const LatencyStats& captureLatency() const { return m_latency; }
+    
+    /* 显示统计（线程安全） */
+    DisplayStats displayStats() const;
+    
     FrameProcessor*     m_processor;     // 帧处理器
+signals:
+    /* 用户在右键菜单中选择了输入源，空表示恢复为主输入源 */
+    void sourceChangeRequested(BasicViewWidget *view, const SourceSpec& source);
 private slots:
-    /* 处理完成后更新显示 */
-    void onFrameProcessed(const cv::Mat& result);
+    /* 在GUI线程中按显示节奏安排下一次绘制 */
+    void schedulePresent();
+    
+    /* 显示周期到了：在工作线程中转换邮箱中最新的结果 */
+    void convertPending();
 
 
 protected:
@@ -47,17 +82,34 @@ protected:
 private:
     Ui::BasicViewWidget *ui;
 
-    QGraphicsScene      m_scene;
-    QGraphicsPixmapItem m_pixItem;
-    double              m_scale = 1.0;   // 当前缩放比例
-    cv::Mat             m_currentFrame;  // 当前处理后的帧（用于导出）
+    cv::Mat             m_currentFrame;  // 当前处理后的帧（用于导出，只读共享）
+    SourceSpec          m_boundSource;   // 绑定的独立输入源
+    LatencyStats        m_latency;       // 采集到显示的延迟
+    
+    /* 显示邮箱：处理线程只放入最新结果，GUI线程每个显示周期最多取一次 */
+    mutable QMutex      m_displayMutex;
+    SharedFrame         m_pendingFrame;      // 尚未显示的最新结果
+    bool                m_presentScheduled = false;  // 已安排绘制，尚未执行
+    bool                m_converting = false;        // 显示转换正在工作线程中进行
+    bool                m_closing = false;           // 正在销毁，不再转换
+    QWaitCondition      m_convertDone;
+    DisplayStats        m_displayStats;
+    QTimer             *m_presentTimer;      // 单次定时器，对齐显示周期
+    QElapsedTimer       m_lastPresent;       // 上次绘制的时刻
+    int                 m_displayFpsCap = 0;         // 绘制帧率上限，0 表示跟随屏幕刷新率
     
     
 
-    /* 事件处理 */
-    void wheelEvent(QWheelEvent *e) override;
-    void mouseDoubleClickEvent(QMouseEvent *) override;
+    int  presentInterval() const;
     void showAlgorithmManager();
+    void addSourceMenu(QMenu *menu);
+    void recordLatency(qint64 latencyUs);
+    
+    /* 处理完成后放入显示邮箱（在处理线程中调用） */
+    void onFrameProcessed(const SharedFrame& result);
+    
+    /* 显示转换好的结果（GUI线程） */
+    void presentFrame(const SharedFrame& result, const FrameCanvas::Prepared& image);
 };
 
 #endif // BASICVIEWWIDGET_H
\ No newline at end of file
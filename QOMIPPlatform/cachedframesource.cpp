@@ -0,0 +1,195 @@
+#include "cachedframesource.h"
+#include <QDebug>
+#include <QFileInfo>
+
+CachedFrameSource::CachedFrameSource(std::unique_ptr<FrameSource> source, const QString& mediaPath)
+    : m_source(std::move(source))
+    , m_mediaPath(mediaPath)
+{
+}
+
+CachedFrameSource::~CachedFrameSource()
+{
+    close();
+}
+
+bool CachedFrameSource::open()
+{
+    if (isOpened()) {
+        return true;
+    }
+    m_next = 0;
+    if (useCachedClip()) {
+        qDebug() << "Playing" << m_mediaPath << "from decoded frame cache," << m_clip->frames.size() << "frames";
+        return true;
+    }
+    if (!m_source->open()) {
+        return false;
+    }
+    startRecording();
+    return true;
+}
+
+void CachedFrameSource::close()
+{
+    m_source->close();
+    m_clip.reset();
+    m_recording.reset();
+}
+
+bool CachedFrameSource::isOpened() const
+{
+    return m_clip || m_source->isOpened();
+}
+
+bool CachedFrameSource::read(cv::Mat& frame, qint64& timestampMs)
+{
+    if (m_clip) {
+        if (m_next >= static_cast<int>(m_clip->frames.size())) {
+            return false;
+        }
+        const DecodedFrameCache::Frame& cached = m_clip->frames[m_next++];
+        if (!DecodedFrameCache::decompress(cached, frame)) {
+            qWarning() << "[CachedFrameSource] 无法解压缓存帧:" << m_mediaPath;
+            return false;
+        }
+        m_format = cached.format;
+        timestampMs = cached.timestampMs;
+        return true;
+    }
+
+    if (!m_source->read(frame, timestampMs)) {
+        finishRecording();
+        return false;
+    }
+    m_format = m_source->pixelFormat();
+
+    if (m_recording) {
+        DecodedFrameCache::Frame cached;
+        if (!DecodedFrameCache::compress(frame, m_format, timestampMs, cached)) {
+            m_recording.reset();
+            m_uncachable = true;
+        } else if (m_recording->frames.empty() && estimatedBytes(cached.bytes()) > DecodedFrameCache::instance().budget()) {
+            // 按第一帧的压缩大小估算整个片段，明显放不下时不再压缩后续的帧
+            qDebug() << "[CachedFrameSource]" << m_mediaPath << "is estimated to exceed the frame cache budget, not cached";
+            m_recording.reset();
+            m_uncachable = true;
+        } else if (m_recording->bytes + cached.bytes() > DecodedFrameCache::instance().budget()) {
+            qDebug() << "[CachedFrameSource]" << m_mediaPath << "exceeds the frame cache budget, not cached";
+            m_recording.reset();
+            m_uncachable = true;
+        } else {
+            m_recording->bytes += cached.bytes();
+            m_recording->frames.push_back(std::move(cached));
+        }
+    }
+    return true;
+}
+
+bool CachedFrameSource::grab(qint64& timestampMs)
+{
+    if (m_clip) {
+        if (m_next >= static_cast<int>(m_clip->frames.size())) {
+            return false;
+        }
+        timestampMs = m_clip->frames[m_next++].timestampMs;
+        return true;
+    }
+
+    // 跳帧说明处理跟不上：放弃这一遍的记录，不为补全片段而解码，下一遍从头再记录
+    if (m_recording) {
+        qDebug() << "[CachedFrameSource]" << m_mediaPath << "skipped a frame while recording, not cached this pass";
+        m_recording.reset();
+    }
+    if (!m_source->grab(timestampMs)) {
+        finishRecording();
+        return false;
+    }
+    return true;
+}
+
+bool CachedFrameSource::rewind()
+{
+    m_next = 0;
+    if (m_clip || useCachedClip()) {
+        return true;
+    }
+    if (!m_source->rewind()) {
+        return false;
+    }
+    startRecording();
+    return true;
+}
+
+bool CachedFrameSource::seek(qint64 timestampMs, bool keyframeOnly)
+{
+    if (m_clip) {
+        // 缓存中每一帧都可以直接解压，关键帧模式与精确定位相同
+        m_next = m_clip->indexAt(timestampMs);
+        return true;
+    }
+
+    // 中途定位后片段不再完整，这一遍不再记录
+    m_recording.reset();
+    return m_source->seek(timestampMs, keyframeOnly);
+}
+
+double CachedFrameSource::nominalFps() const
+{
+    return m_clip ? m_clip->fps : m_source->nominalFps();
+}
+
+qint64 CachedFrameSource::durationMs() const
+{
+    return m_clip ? m_clip->durationMs : m_source->durationMs();
+}
+
+void CachedFrameSource::startRecording()
+{
+    m_recording.reset();
+    if (m_uncachable || !DecodedFrameCache::instance().isEnabled()) {
+        return;
+    }
+    const QFileInfo info(m_mediaPath);
+    m_recording = std::make_shared<DecodedFrameCache::Clip>();
+    m_recording->fps = m_source->nominalFps();
+    m_recording->durationMs = m_source->durationMs();
+    m_recording->fileSize = info.size();
+    m_recording->modified = info.lastModified();
+}
+
+qint64 CachedFrameSource::estimatedBytes(qint64 frameBytes) const
+{
+    // 时长或帧率未知时无法估算，只按已记录的数据量判断
+    if (m_recording->durationMs <= 0 || m_recording->fps <= 0.0) {
+        return frameBytes;
+    }
+    return qRound64(m_recording->durationMs * m_recording->fps / 1000.0) * frameBytes;
+}
+
+void CachedFrameSource::finishRecording()
+{
+    if (m_recording && !m_recording->frames.empty()) {
+        if (m_recording->durationMs < 0) {
+            const double fps = m_recording->fps;
+            m_recording->durationMs = m_recording->frames.back().timestampMs
+                                      + (fps > 0.0 ? qRound64(1000.0 / fps) : 0);
+        }
+        DecodedFrameCache::instance().insert(m_mediaPath, std::move(m_recording));
+    }
+    m_recording.reset();
+}
+
+bool CachedFrameSource::useCachedClip()
+{
+    if (!DecodedFrameCache::instance().isEnabled()) {
+        return false;
+    }
+    m_clip = DecodedFrameCache::instance().find(m_mediaPath);
+    if (!m_clip) {
+        return false;
+    }
+    m_recording.reset();
+    m_source->close();  // 之后不再需要解码器
+    return true;
+}
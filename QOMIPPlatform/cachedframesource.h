@@ -0,0 +1,68 @@
+#pragma once
+
+#include <memory>
+#include "decodedframecache.h"
+#include "framesource.h"
+
+/**
+ * @class CachedFrameSource
+ * @brief 通过 DecodedFrameCache 播放视频文件的输入源包装
+ *
+ * 缓存中有完整片段时不打开被包装的输入源，读取、回绕和定位都只解压缓存；
+ * 否则从被包装的输入源解码，并在从头到尾的第一遍播放中记录每一帧，
+ * 到达结尾时把片段放入缓存，之后的回绕切换为从缓存播放。
+ * 按第一帧的压缩大小估算片段，超出预算时不记录；记录期间需要跳帧时放弃这一遍的记录，
+ * 不为补全片段而解码跳过的帧。
+ */
+class CachedFrameSource : public FrameSource {
+public:
+    /**
+     * @param source 被包装的文件输入源，所有权转移
+     * @param mediaPath 视频文件路径（缓存键）
+     */
+    CachedFrameSource(std::unique_ptr<FrameSource> source, const QString& mediaPath);
+    ~CachedFrameSource() override;
+
+    bool open() override;
+    void close() override;
+    bool isOpened() const override;
+    bool isLive() const override { return false; }
+    bool read(cv::Mat& frame, qint64& timestampMs) override;
+    bool grab(qint64& timestampMs) override;
+    void requestStop() override { m_source->requestStop(); }
+    bool rewind() override;
+    bool seek(qint64 timestampMs, bool keyframeOnly) override;
+    QString description() const override { return m_source->description(); }
+    double nominalFps() const override;
+    qint64 durationMs() const override;
+    SharedFrame::PixelFormat pixelFormat() const override { return m_format; }
+
+private:
+    /**
+     * @brief 从头开始记录新片段（预算内）
+     */
+    void startRecording();
+
+    /**
+     * @brief 按一帧的压缩大小估算整个片段的数据量
+     */
+    qint64 estimatedBytes(qint64 frameBytes) const;
+
+    /**
+     * @brief 到达结尾：把记录的片段放入缓存
+     */
+    void finishRecording();
+
+    /**
+     * @brief 切换为从缓存播放并关闭解码器，缓存中没有片段时返回false
+     */
+    bool useCachedClip();
+
+    std::unique_ptr<FrameSource> m_source;
+    const QString m_mediaPath;
+    std::shared_ptr<const DecodedFrameCache::Clip> m_clip;     ///< 正在播放的缓存片段
+    std::shared_ptr<DecodedFrameCache::Clip> m_recording;      ///< 第一遍播放时记录的片段
+    int m_next = 0;                 ///< 从缓存播放时下一帧的下标
+    bool m_uncachable = false;      ///< 片段超出预算或帧无法压缩，不再尝试记录
+    SharedFrame::PixelFormat m_format = SharedFrame::PixelFormat::BGR;
+};
@@ -0,0 +1,260 @@
+#include "captureframesource.h"
+#include "keyframeindex.h"
+#include <QDebug>
+#include <QThread>
+#include <opencv2/videoio/registry.hpp>
+
+CaptureFrameSource::CaptureFrameSource(const QString& path, bool nativeYuv, bool emulateCamera)
+    : m_path(path), m_nativeYuv(nativeYuv), m_emulateCamera(emulateCamera)
+{
+}
+
+CaptureFrameSource::CaptureFrameSource(int cameraIndex, bool nativeYuv)
+    : m_cameraIndex(cameraIndex), m_nativeYuv(nativeYuv)
+{
+}
+
+CaptureFrameSource::~CaptureFrameSource()
+{
+    close();
+}
+
+bool CaptureFrameSource::open()
+{
+    if (m_cap.isOpened()) {
+        return true;
+    }
+
+    bool success = false;
+    m_yuvPipeline = m_nativeYuv && openNativeYuv();
+    m_format = SharedFrame::PixelFormat::BGR;
+    if (m_cameraIndex < 0) {
+        success = m_yuvPipeline;
+        if (!success && !m_path.isEmpty()) {
+            success = m_cap.open(m_path.toStdString());
+        }
+        if (!success) {
+            qWarning() << "无法打开视频文件：" << m_path;
+            return false;
+        }
+        m_fps = m_cap.get(cv::CAP_PROP_FPS);
+        if (!(m_fps > 0.0 && m_fps < 1000.0)) {
+            m_fps = 0.0;    // 部分容器不提供帧率
+        }
+        m_lastTimestamp = -1;
+        
+        if (m_emulateCamera) {
+            // 模拟摄像头从打开时刻起按帧率出帧，时间戳与真实摄像头一样来自单调时钟
+            m_durationMs = -1;
+            m_emulatedFrames = 0;
+            m_clock.start();
+            qDebug() << "Opened" << m_path << "as emulated camera, fps:" << m_fps;
+            return true;
+        }
+        
+        const double frames = m_cap.get(cv::CAP_PROP_FRAME_COUNT);
+        m_durationMs = (m_fps > 0.0 && frames > 0.0) ? qRound64(frames * 1000.0 / m_fps) : -1;
+        
+        // 关键帧索引在后台准备，定位时就绪才使用
+        KeyframeIndexer::instance().request(m_path);
+        qDebug() << "Opened" << m_path << "fps:" << m_fps << (m_yuvPipeline ? "(I420)" : "");
+        return true;
+    }
+
+    if (m_yuvPipeline) {
+        m_clock.start();
+        qDebug() << "Opened camera" << m_cameraIndex << "as I420";
+        return true;
+    }
+
+    // 尝试使用适合平台的后端打开摄像头
+#ifdef Q_OS_WIN
+    success = m_cap.open(m_cameraIndex, cv::CAP_DSHOW);
+#elif defined(Q_OS_MAC)
+    success = m_cap.open(m_cameraIndex, cv::CAP_AVFOUNDATION);
+#elif defined(Q_OS_LINUX)
+    success = m_cap.open(m_cameraIndex, cv::CAP_V4L2);
+#else
+    success = m_cap.open(m_cameraIndex);
+#endif
+
+    if (!success) {
+        // 如果特定后端失败，尝试默认后端
+        success = m_cap.open(m_cameraIndex);
+    }
+
+    if (!success) {
+        qWarning() << "无法打开摄像头：" << m_cameraIndex;
+    } else {
+        // 驱动队列只保留一帧（后端不支持时忽略），采集循环持续 grab() 取走最新帧
+        m_cap.set(cv::CAP_PROP_BUFFERSIZE, 1);
+        m_clock.start();
+        qDebug() << "Successfully opened camera" << m_cameraIndex;
+    }
+    return success;
+}
+
+bool CaptureFrameSource::openNativeYuv()
+{
+    // OpenCV 的 FFmpeg/V4L2 后端总是转换为 BGR，只有 GStreamer 的 appsink 能交出平面 YUV
+    if (!cv::videoio_registry::hasBackend(cv::CAP_GSTREAMER)) {
+        return false;
+    }
+
+    QString pipeline;
+    if (m_cameraIndex < 0) {
+        if (m_path.isEmpty()) {
+            return false;
+        }
+        QString location = m_path;
+        location.replace("\\", "\\\\").replace("\"", "\\\"");
+        pipeline = QString("filesrc location=\"%1\" ! decodebin ! videoconvert ! "
+                           "video/x-raw,format=I420 ! appsink sync=false").arg(location);
+    } else {
+#ifdef Q_OS_LINUX
+        pipeline = QString("v4l2src device=/dev/video%1 ! videoconvert ! "
+                           "video/x-raw,format=I420 ! appsink sync=false drop=true max-buffers=2")
+                       .arg(m_cameraIndex);
+#else
+        return false;
+#endif
+    }
+
+    // 解码器原生输出大多就是 I420/NV12，videoconvert 此时只是直通
+    if (!m_cap.open(pipeline.toStdString(), cv::CAP_GSTREAMER)) {
+        return false;
+    }
+    m_frameHeight = static_cast<int>(m_cap.get(cv::CAP_PROP_FRAME_HEIGHT));
+    return true;
+}
+
+void CaptureFrameSource::close()
+{
+    if (m_cap.isOpened()) {
+        m_cap.release();
+    }
+}
+
+bool CaptureFrameSource::isOpened() const
+{
+    return m_cap.isOpened();
+}
+
+bool CaptureFrameSource::read(cv::Mat& frame, qint64& timestampMs)
+{
+    return grab(timestampMs) && retrieve(frame);
+}
+
+bool CaptureFrameSource::retrieve(cv::Mat& frame)
+{
+    // 每次读入新的Mat，发出后缓冲区只读共享，不会被下一帧覆盖
+    cv::Mat image;
+    if (!m_cap.retrieve(image) || image.empty()) {
+        return false;
+    }
+
+    // I420 管线输出单通道的 (h*3/2) x w 缓冲；其它情况（管线协商失败等）按普通图像处理
+    m_format = m_yuvPipeline && image.type() == CV_8UC1
+               && (m_frameHeight <= 0 ? image.rows % 3 == 0 : image.rows == m_frameHeight * 3 / 2)
+            ? SharedFrame::PixelFormat::I420 : SharedFrame::PixelFormat::BGR;
+
+    frame = image;
+    return true;
+}
+
+bool CaptureFrameSource::grab(qint64& timestampMs)
+{
+    if (m_emulateCamera) {
+        paceEmulatedCamera();
+    }
+    if (!m_cap.grab()) {
+        // 模拟摄像头到结尾后从头循环
+        if (!m_emulateCamera || !m_cap.set(cv::CAP_PROP_POS_FRAMES, 0) || !m_cap.grab()) {
+            return false;
+        }
+    }
+    timestampMs = currentTimestamp();
+    return true;
+}
+
+void CaptureFrameSource::paceEmulatedCamera()
+{
+    // 像真实摄像头一样按帧率出帧：采集循环取得慢时，中间的帧不会堆积
+    const double fps = m_fps > 0.0 ? m_fps : 30.0;
+    const qint64 due = qRound64(m_emulatedFrames * 1000.0 / fps);
+    const qint64 wait = due - m_clock.elapsed();
+    if (wait > 0) {
+        QThread::msleep(static_cast<unsigned long>(wait));
+    } else if (wait < -1000) {
+        // 长时间没有取帧（如暂停）：不补发积压的帧
+        m_emulatedFrames = qRound64(m_clock.elapsed() * fps / 1000.0);
+    }
+    ++m_emulatedFrames;
+}
+
+qint64 CaptureFrameSource::currentTimestamp()
+{
+    // 摄像头（包括模拟摄像头）使用单调时钟
+    if (isLive()) {
+        return m_clock.elapsed();
+    }
+
+    // 文件使用容器时间戳；某些后端不提供（恒为0或不递增），此时按帧号和帧率推算
+    qint64 timestamp = static_cast<qint64>(m_cap.get(cv::CAP_PROP_POS_MSEC));
+    if (timestamp <= m_lastTimestamp && m_fps > 0.0) {
+        const double index = m_cap.get(cv::CAP_PROP_POS_FRAMES) - 1.0;
+        timestamp = qMax(m_lastTimestamp + 1, static_cast<qint64>(index * 1000.0 / m_fps));
+    }
+    m_lastTimestamp = timestamp;
+    return timestamp;
+}
+
+bool CaptureFrameSource::rewind()
+{
+    if (isLive() || !m_cap.isOpened()) {
+        return false;
+    }
+    m_lastTimestamp = -1;
+    return m_cap.set(cv::CAP_PROP_POS_FRAMES, 0);
+}
+
+bool CaptureFrameSource::seek(qint64 timestampMs, bool keyframeOnly)
+{
+    if (isLive() || !m_cap.isOpened()) {
+        return false;
+    }
+    timestampMs = qMax<qint64>(0, timestampMs);
+    m_lastTimestamp = -1;
+
+    const std::shared_ptr<const KeyframeIndex> index = KeyframeIndexer::instance().find(m_path);
+    if (!index || !index->hasKeyframes()) {
+        // 索引未就绪或没有关键帧信息：交给后端定位（FFmpeg 后端同样从关键帧向前解码，但较慢）
+        return m_cap.set(cv::CAP_PROP_POS_MSEC, static_cast<double>(timestampMs));
+    }
+
+    // 定位到关键帧本身只需解码这一帧
+    const KeyframeIndex::Keyframe key = index->keyframeAtOrBefore(timestampMs);
+    if (!m_cap.set(cv::CAP_PROP_POS_FRAMES, key.frame)) {
+        return false;
+    }
+    if (keyframeOnly) {
+        return true;
+    }
+
+    // 从关键帧向前解码到目标帧，只 grab() 不做颜色转换
+    const int target = index->frameAt(timestampMs);
+    for (int frame = key.frame; frame < target; ++frame) {
+        if (!m_cap.grab()) {
+            break;
+        }
+    }
+    return true;
+}
+
+QString CaptureFrameSource::description() const
+{
+    if (m_emulateCamera) {
+        return QString("模拟摄像头 (%1)").arg(m_path);
+    }
+    return isLive() ? QString("摄像头 %1").arg(m_cameraIndex) : m_path;
+}
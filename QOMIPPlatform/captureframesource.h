@@ -0,0 +1,73 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include "framesource.h"
+
+/**
+ * @class CaptureFrameSource
+ * @brief 基于 cv::VideoCapture 的视频文件/摄像头输入源
+ *
+ * 视频文件也可以作为模拟摄像头打开：按文件帧率实时放出帧、到结尾后循环，
+ * 与真实摄像头一样是实时源，用于在没有摄像头的环境中验证实时采集路径。
+ */
+class CaptureFrameSource : public FrameSource {
+public:
+    /**
+     * @param path 视频文件路径
+     * @param nativeYuv 尽量让解码器直接输出 I420，不做 BGR 转换（需要 GStreamer 后端）
+     * @param emulateCamera 作为模拟摄像头打开：按帧率实时放出帧并循环播放
+     */
+    explicit CaptureFrameSource(const QString& path, bool nativeYuv = false, bool emulateCamera = false);
+
+    /**
+     * @param cameraIndex 摄像头索引
+     * @param nativeYuv 尽量让摄像头直接输出 I420（需要 GStreamer 后端，仅Linux）
+     */
+    explicit CaptureFrameSource(int cameraIndex, bool nativeYuv = false);
+
+    ~CaptureFrameSource() override;
+
+    bool open() override;
+    void close() override;
+    bool isOpened() const override;
+    bool isLive() const override { return m_cameraIndex >= 0 || m_emulateCamera; }
+    bool read(cv::Mat& frame, qint64& timestampMs) override;
+    bool grab(qint64& timestampMs) override;
+    bool retrieve(cv::Mat& frame) override;
+    bool rewind() override;
+    bool seek(qint64 timestampMs, bool keyframeOnly) override;
+    qint64 durationMs() const override { return m_durationMs; }
+    QString description() const override;
+    double nominalFps() const override { return m_fps; }
+    SharedFrame::PixelFormat pixelFormat() const override { return m_format; }
+
+private:
+    /**
+     * @brief 通过 GStreamer 管线打开，输出 I420；不可用时返回false，由调用方回退
+     */
+    bool openNativeYuv();
+
+    /**
+     * @brief 当前帧的时间戳：文件优先使用容器时间戳，不可用时按帧号和帧率推算
+     */
+    qint64 currentTimestamp();
+
+    /**
+     * @brief 模拟摄像头：等到下一帧按帧率应当到达的时刻
+     */
+    void paceEmulatedCamera();
+
+    QString m_path;             ///< 视频文件路径
+    int m_cameraIndex = -1;     ///< 摄像头索引，文件源为-1
+    cv::VideoCapture m_cap;     ///< OpenCV视频捕获对象
+    QElapsedTimer m_clock;      ///< 单调时钟，为摄像头帧提供时间戳
+    double m_fps = 0.0;         ///< CAP_PROP_FPS，未知时为0
+    qint64 m_durationMs = -1;   ///< 文件时长，未知时为-1
+    qint64 m_lastTimestamp = -1;    ///< 上一帧时间戳，用于检测容器时间戳是否可用
+    bool m_nativeYuv = false;   ///< 是否请求平面YUV输出
+    bool m_yuvPipeline = false; ///< 当前是否由 I420 管线打开
+    int m_frameHeight = 0;      ///< I420 管线的帧高度，用于识别输出缓冲
+    bool m_emulateCamera = false;   ///< 把视频文件当作摄像头
+    qint64 m_emulatedFrames = 0;    ///< 模拟摄像头已放出的帧数
+    SharedFrame::PixelFormat m_format = SharedFrame::PixelFormat::BGR;  ///< 最近一帧的格式
+};
@@ -0,0 +1,178 @@
+#include "decodedframecache.h"
+#include "taskscheduler.h"
+#include <QDebug>
+#include <QFileInfo>
+#include <QSettings>
+#include <algorithm>
+#include <atomic>
+
+namespace {
+
+// 条带数：每条至少64行，最多8条
+int stripCount(int rows)
+{
+    return qBound(1, rows / 64, 8);
+}
+
+int stripBegin(int rows, int strips, int index)
+{
+    return static_cast<int>(static_cast<qint64>(rows) * index / strips);
+}
+
+} // namespace
+
+qint64 DecodedFrameCache::Frame::bytes() const
+{
+    qint64 total = 0;
+    for (const std::vector<uchar>& strip : strips) {
+        total += static_cast<qint64>(strip.size());
+    }
+    return total;
+}
+
+int DecodedFrameCache::Clip::indexAt(qint64 timestampMs) const
+{
+    auto it = std::upper_bound(frames.begin(), frames.end(), timestampMs,
+                               [](qint64 ms, const Frame& frame) { return ms < frame.timestampMs; });
+    return it == frames.begin() ? 0 : static_cast<int>(it - frames.begin()) - 1;
+}
+
+DecodedFrameCache& DecodedFrameCache::instance()
+{
+    static DecodedFrameCache cache;
+    return cache;
+}
+
+DecodedFrameCache::DecodedFrameCache()
+{
+    QSettings settings("QOMIPPlatform", "Reader");
+    m_budget = qMax<qint64>(0, settings.value("frame_cache_mb", 0).toLongLong()) * 1024 * 1024;
+}
+
+qint64 DecodedFrameCache::budget() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_budget;
+}
+
+void DecodedFrameCache::setBudget(qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_budget = qMax<qint64>(0, bytes);
+    evictLocked(0);
+}
+
+QString DecodedFrameCache::keyOf(const QString& mediaPath)
+{
+    const QString canonical = QFileInfo(mediaPath).canonicalFilePath();
+    return canonical.isEmpty() ? mediaPath : canonical;
+}
+
+std::shared_ptr<const DecodedFrameCache::Clip> DecodedFrameCache::find(const QString& mediaPath)
+{
+    const QString key = keyOf(mediaPath);
+    const QFileInfo info(mediaPath);
+    QMutexLocker locker(&m_mutex);
+    const std::shared_ptr<const Clip> clip = m_clips.value(key);
+    if (!clip) {
+        return nullptr;
+    }
+    if (clip->fileSize != info.size() || clip->modified != info.lastModified()) {
+        // 文件已变化
+        m_bytes -= clip->bytes;
+        m_clips.remove(key);
+        m_recent.removeAll(key);
+        return nullptr;
+    }
+    m_recent.removeAll(key);
+    m_recent.append(key);
+    return clip;
+}
+
+void DecodedFrameCache::insert(const QString& mediaPath, std::shared_ptr<const Clip> clip)
+{
+    if (!clip || clip->frames.empty()) {
+        return;
+    }
+    const QString key = keyOf(mediaPath);
+    QMutexLocker locker(&m_mutex);
+    if (clip->bytes > m_budget) {
+        return;
+    }
+    if (const std::shared_ptr<const Clip> old = m_clips.take(key)) {
+        m_bytes -= old->bytes;
+        m_recent.removeAll(key);
+    }
+    evictLocked(clip->bytes);
+    m_bytes += clip->bytes;
+    m_clips.insert(key, std::move(clip));
+    m_recent.append(key);
+    qDebug() << "[DecodedFrameCache]" << key << "cached," << m_bytes / (1024 * 1024)
+             << "MB of" << m_budget / (1024 * 1024) << "MB used";
+}
+
+void DecodedFrameCache::evictLocked(qint64 incoming)
+{
+    while (!m_recent.isEmpty() && m_bytes + incoming > m_budget) {
+        const QString key = m_recent.takeFirst();
+        if (const std::shared_ptr<const Clip> clip = m_clips.take(key)) {
+            m_bytes -= clip->bytes;
+        }
+    }
+}
+
+bool DecodedFrameCache::compress(const cv::Mat& image, SharedFrame::PixelFormat format,
+                                 qint64 timestampMs, Frame& frame)
+{
+    const int channels = image.channels();
+    if (image.empty() || (image.depth() != CV_8U && image.depth() != CV_16U)
+        || (channels != 1 && channels != 3 && channels != 4)) {
+        return false;   // PNG 不支持的类型
+    }
+
+    frame.rows = image.rows;
+    frame.cols = image.cols;
+    frame.type = image.type();
+    frame.format = format;
+    frame.timestampMs = timestampMs;
+
+    // 只求速度：最快的 zlib 级别，PNG 的行预测滤波仍能明显减小自然图像
+    const std::vector<int> params = {cv::IMWRITE_PNG_COMPRESSION, 1};
+    const int strips = stripCount(image.rows);
+    frame.strips.assign(strips, std::vector<uchar>());
+    std::atomic<bool> ok{true};
+    TaskScheduler::instance().parallelFor(strips, [&](int index) {
+        const cv::Mat strip = image.rowRange(stripBegin(image.rows, strips, index),
+                                             stripBegin(image.rows, strips, index + 1));
+        if (!cv::imencode(".png", strip, frame.strips[index], params)) {
+            ok = false;
+        }
+    });
+    return ok;
+}
+
+bool DecodedFrameCache::decompress(const Frame& frame, cv::Mat& image)
+{
+    const int strips = static_cast<int>(frame.strips.size());
+    if (strips == 0) {
+        return false;
+    }
+
+    cv::Mat output(frame.rows, frame.cols, frame.type);
+    std::atomic<bool> ok{true};
+    TaskScheduler::instance().parallelFor(strips, [&](int index) {
+        cv::Mat rows = output.rowRange(stripBegin(frame.rows, strips, index),
+                                       stripBegin(frame.rows, strips, index + 1));
+        const cv::Mat decoded = cv::imdecode(frame.strips[index], cv::IMREAD_UNCHANGED);
+        if (decoded.size() != rows.size() || decoded.type() != rows.type()) {
+            ok = false;
+            return;
+        }
+        decoded.copyTo(rows);
+    });
+    if (!ok) {
+        return false;
+    }
+    image = output;
+    return true;
+}
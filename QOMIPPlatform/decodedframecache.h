@@ -0,0 +1,103 @@
+#pragma once
+
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <memory>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "sharedframe.h"
+
+/**
+ * @class DecodedFrameCache
+ * @brief 短视频循环播放用的解码帧缓存
+ *
+ * 文件第一次完整播放时把每一帧无损压缩后记录下来，之后的回绕和定位直接从内存解压，
+ * 不再打开解码器。只缓存完整的片段：播放中途定位或超出内存预算时放弃记录。
+ *
+ * 帧按水平条带分别用 PNG（最快的 zlib 级别）无损压缩，条带在共享线程池中并行编解码。
+ * 所有片段共用一个内存预算（QSettings `Reader/frame_cache_mb`，0 表示关闭），
+ * 超出时淘汰最久未使用的片段。所有接口都是线程安全的。
+ */
+class DecodedFrameCache {
+public:
+    /**
+     * @brief 压缩后的一帧
+     */
+    struct Frame {
+        std::vector<std::vector<uchar>> strips;     ///< 各水平条带的PNG数据
+        int rows = 0;
+        int cols = 0;
+        int type = 0;                               ///< cv::Mat 类型
+        SharedFrame::PixelFormat format = SharedFrame::PixelFormat::BGR;
+        qint64 timestampMs = 0;
+
+        qint64 bytes() const;
+    };
+
+    /**
+     * @brief 一个视频文件的全部帧
+     */
+    struct Clip {
+        std::vector<Frame> frames;      ///< 按播放顺序
+        double fps = 0.0;
+        qint64 durationMs = -1;
+        qint64 bytes = 0;               ///< 压缩数据总量
+        qint64 fileSize = 0;            ///< 记录时的文件大小，用于校验
+        QDateTime modified;             ///< 记录时的文件修改时间，用于校验
+
+        /**
+         * @brief 时间戳不晚于 timestampMs 的最后一帧的下标（没有时为0）
+         */
+        int indexAt(qint64 timestampMs) const;
+    };
+
+    static DecodedFrameCache& instance();
+
+    /**
+     * @brief 内存预算(字节)，0 表示不缓存
+     */
+    qint64 budget() const;
+    void setBudget(qint64 bytes);
+    bool isEnabled() const { return budget() > 0; }
+
+    /**
+     * @brief 查找完整的片段，文件已变化时返回nullptr
+     */
+    std::shared_ptr<const Clip> find(const QString& mediaPath);
+
+    /**
+     * @brief 放入一个完整片段，必要时淘汰最久未使用的片段
+     *
+     * 正在播放的片段被淘汰后由播放方的引用保活，播放结束才释放。
+     */
+    void insert(const QString& mediaPath, std::shared_ptr<const Clip> clip);
+
+    /**
+     * @brief 无损压缩一帧（支持 8U/16U 的 1、3、4 通道）
+     */
+    static bool compress(const cv::Mat& image, SharedFrame::PixelFormat format, qint64 timestampMs,
+                         Frame& frame);
+
+    /**
+     * @brief 解压到新分配的缓冲区
+     */
+    static bool decompress(const Frame& frame, cv::Mat& image);
+
+    static QString keyOf(const QString& mediaPath);
+
+private:
+    DecodedFrameCache();
+    DecodedFrameCache(const DecodedFrameCache&) = delete;
+    DecodedFrameCache& operator=(const DecodedFrameCache&) = delete;
+
+    void evictLocked(qint64 incoming);
+
+    mutable QMutex m_mutex;
+    QHash<QString, std::shared_ptr<const Clip>> m_clips;    // 规范化路径 -> 片段
+    QStringList m_recent;                                   // 最近使用的在末尾
+    qint64 m_bytes = 0;
+    qint64 m_budget = 0;
+};
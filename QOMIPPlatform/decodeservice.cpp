@@ -0,0 +1,272 @@
+#include "decodeservice.h"
+#include "basicviewwidget.h"
+#include "framecreditpool.h"
+#include "sharedprefixcache.h"
+#include <QDebug>
+#include <QFileInfo>
+#include <QSettings>
+
+SourceSpec SourceSpec::file(const QString& path)
+{
+    SourceSpec spec;
+    spec.type = Reader::SOURCE_FILE;
+    spec.path = path;
+    return spec;
+}
+
+SourceSpec SourceSpec::camera(int cameraIndex)
+{
+    SourceSpec spec;
+    spec.type = Reader::SOURCE_CAMERA;
+    spec.cameraIndex = cameraIndex;
+    return spec;
+}
+
+QString SourceSpec::key() const
+{
+    switch (type) {
+    case Reader::SOURCE_FILE: {
+        // 同一文件的不同写法（相对路径、符号链接）视为同一输入源
+        const QString canonical = QFileInfo(path).canonicalFilePath();
+        return "file:" + (canonical.isEmpty() ? path : canonical);
+    }
+    case Reader::SOURCE_CAMERA:
+        return QString("camera:%1").arg(cameraIndex);
+    case Reader::SOURCE_NONE:
+    default:
+        return QString();
+    }
+}
+
+QString SourceSpec::displayName() const
+{
+    switch (type) {
+    case Reader::SOURCE_FILE:
+        return QFileInfo(path).fileName();
+    case Reader::SOURCE_CAMERA:
+        return QString("摄像头 %1").arg(cameraIndex);
+    case Reader::SOURCE_NONE:
+    default:
+        return "主输入源";
+    }
+}
+
+DecodeService::DecodeService(QObject *parent)
+    : QObject(parent)
+    , m_basePrefixWindow(SharedPrefixCache::instance().window())
+{
+    // 读取线程只负责节奏和分发，解码在各输入源的预取线程中，少量线程即可承载多路输入
+    QSettings settings("QOMIPPlatform", "Scheduler");
+    const int automatic = qBound(1, QThread::idealThreadCount() / 2, 4);
+    const int configured = settings.value("decode_threads", 0).toInt();
+    m_maxThreads = configured > 0 ? configured : automatic;
+}
+
+DecodeService::~DecodeService()
+{
+    // 先在各自线程中停止Reader（停止定时器、退出预取线程），再结束线程
+    for (Stream *stream : std::as_const(m_streams)) {
+        QMetaObject::invokeMethod(stream->reader, "stop", Qt::BlockingQueuedConnection);
+    }
+    for (QThread *thread : std::as_const(m_threads)) {
+        thread->quit();
+        thread->wait();
+    }
+    for (Stream *stream : std::as_const(m_streams)) {
+        delete stream->reader;
+        delete stream->creditPool;
+        delete stream;
+    }
+    m_streams.clear();
+    m_bindings.clear();
+    qDeleteAll(m_threads);
+    m_threads.clear();
+}
+
+void DecodeService::bind(BasicViewWidget *view, const SourceSpec& source)
+{
+    if (!view) {
+        return;
+    }
+    if (source.isNull()) {
+        unbind(view);
+        return;
+    }
+
+    const QString key = source.key();
+    if (m_bindings.value(view).key == key) {
+        return;
+    }
+    unbind(view);
+
+    Stream *stream = m_streams.value(key, nullptr);
+    if (!stream) {
+        stream = openStream(source);
+        m_streams.insert(key, stream);
+        updatePrefixWindow();
+    }
+
+    stream->views.append(view);
+    stream->creditPool->addConsumer(view->m_processor);
+
+    // 视图销毁时自动解绑；只用地址，不再访问正在析构的对象
+    Binding binding;
+    binding.key = key;
+    binding.processor = view->m_processor;
+    binding.destroyed = connect(view, &QObject::destroyed, this, [this, view]() {
+        unbind(view);
+    });
+    m_bindings.insert(view, binding);
+
+    qDebug() << "[DecodeService]:" << view->objectName() << "->" << key
+             << "streams:" << m_streams.size() << "threads:" << m_threads.size();
+}
+
+void DecodeService::unbind(BasicViewWidget *view)
+{
+    const Binding binding = m_bindings.take(view);
+    if (binding.key.isEmpty()) {
+        return;
+    }
+    disconnect(binding.destroyed);
+
+    Stream *stream = m_streams.value(binding.key, nullptr);
+    if (!stream) {
+        return;
+    }
+    stream->views.removeAll(view);
+    stream->creditPool->removeConsumer(binding.processor);
+
+    // 没有视图再使用的输入源立即关闭
+    if (stream->views.isEmpty()) {
+        closeStream(binding.key);
+    }
+}
+
+SourceSpec DecodeService::sourceOf(BasicViewWidget *view) const
+{
+    const Stream *stream = m_streams.value(m_bindings.value(view).key, nullptr);
+    return stream ? stream->source : SourceSpec();
+}
+
+void DecodeService::setPlaying(bool playing)
+{
+    m_playing = playing;
+    for (Stream *stream : std::as_const(m_streams)) {
+        QMetaObject::invokeMethod(stream->reader, playing ? "play" : "pause", Qt::QueuedConnection);
+    }
+}
+
+void DecodeService::setMaxThroughput(bool enabled)
+{
+    m_maxThroughput = enabled;
+    for (Stream *stream : std::as_const(m_streams)) {
+        QMetaObject::invokeMethod(stream->reader, "setMaxThroughput", Qt::QueuedConnection,
+                                  Q_ARG(bool, enabled));
+    }
+}
+
+DecodeService::Stream *DecodeService::openStream(const SourceSpec& source)
+{
+    Stream *stream = new Stream;
+    stream->source = source;
+    stream->creditPool = new FrameCreditPool();
+    stream->reader = new Reader();
+    stream->thread = acquireThread();
+
+    // 与主输入源相同的配置方式，在移动到读取线程之前完成
+    Reader *reader = stream->reader;
+    reader->setCreditPool(stream->creditPool);
+    if (source.type == Reader::SOURCE_FILE) {
+        reader->setSource(source.path);
+    } else {
+        reader->setCameraSource(source.cameraIndex);
+    }
+    reader->setMaxThroughput(m_maxThroughput);
+    reader->moveToThread(stream->thread);
+
+    connect(stream->creditPool, &FrameCreditPool::creditsAvailable,
+            reader, &Reader::onCreditsAvailable);
+
+    // 帧在GUI线程中分发给绑定的视图；记录发送者，丢弃已关闭输入源的滞留帧
+    const QString key = source.key();
+    connect(reader, &Reader::frameReady, this, [this, key, reader](const SharedFrame& frame) {
+        deliver(key, reader, frame);
+    });
+    const QString name = source.displayName();
+    connect(reader, &Reader::processingFinished, this, [this, name](const QString& message) {
+        emit streamFinished(name, message);
+    });
+
+    if (m_playing) {
+        QMetaObject::invokeMethod(reader, "play", Qt::QueuedConnection);
+    }
+    return stream;
+}
+
+void DecodeService::closeStream(const QString& key)
+{
+    Stream *stream = m_streams.take(key);
+    if (!stream) {
+        return;
+    }
+
+    // Reader 在自己的线程中停止后才销毁；信用池要比 Reader 活得久
+    Reader *reader = stream->reader;
+    FrameCreditPool *pool = stream->creditPool;
+    disconnect(reader, nullptr, this, nullptr);
+    connect(reader, &QObject::destroyed, pool, &QObject::deleteLater);
+    QMetaObject::invokeMethod(reader, "stop", Qt::QueuedConnection);
+    reader->deleteLater();
+
+    // 读取线程保留给之后的输入源复用
+    m_threadLoad[stream->thread]--;
+    delete stream;
+    updatePrefixWindow();
+
+    qDebug() << "[DecodeService]: closed" << key << "streams:" << m_streams.size();
+}
+
+void DecodeService::deliver(const QString& key, const Reader *reader, const SharedFrame& frame)
+{
+    Stream *stream = m_streams.value(key, nullptr);
+    if (!stream || stream->reader != reader) {
+        return;
+    }
+
+    // 同一共享帧分发给所有绑定的视图，不拷贝像素
+    for (BasicViewWidget *view : std::as_const(stream->views)) {
+        view->processFrame(frame);
+    }
+
+    // 帧已进入各处理器队列，不再计为在途帧
+    stream->creditPool->releaseFrame();
+}
+
+QThread *DecodeService::acquireThread()
+{
+    // 线程数未达上限且现有线程都有负载时新建，否则选负载最小的线程
+    QThread *best = nullptr;
+    for (QThread *thread : std::as_const(m_threads)) {
+        if (!best || m_threadLoad.value(thread) < m_threadLoad.value(best)) {
+            best = thread;
+        }
+    }
+
+    if (!best || (m_threadLoad.value(best) > 0 && m_threads.size() < m_maxThreads)) {
+        best = new QThread();
+        best->setObjectName(QString("DecodeService-%1").arg(m_threads.size()));
+        best->start();
+        m_threads.append(best);
+    }
+
+    m_threadLoad[best]++;
+    return best;
+}
+
+void DecodeService::updatePrefixWindow()
+{
+    // 帧序号在所有输入源间全局递增，保留窗口按输入源数放大，
+    // 保证每路输入的最近几帧都还在缓存中
+    SharedPrefixCache::instance().setWindow(m_basePrefixWindow * (1 + m_streams.size()));
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include <QThread>
+#include "Reader.h"
+
+class BasicViewWidget;
+class FrameCreditPool;
+class FrameProcessor;
+
+/**
+ * @brief 视图绑定的输入源
+ */
+struct SourceSpec {
+    Reader::SourceType type = Reader::SOURCE_NONE;  ///< SOURCE_NONE 表示跟随主输入源
+    QString path;                                   ///< 视频文件路径
+    int cameraIndex = -1;                           ///< 摄像头索引
+
+    static SourceSpec file(const QString& path);
+    static SourceSpec camera(int cameraIndex);
+
+    bool isNull() const { return type == Reader::SOURCE_NONE; }
+
+    /**
+     * @brief 去重用的键：同一文件（规范化路径）或同一摄像头得到相同的键
+     */
+    QString key() const;
+
+    /**
+     * @brief 用于界面显示的名称
+     */
+    QString displayName() const;
+};
+
+/**
+ * @class DecodeService
+ * @brief 为视图提供各自独立输入源的集中解码服务
+ *
+ * 每个不同的输入源只打开一个 Reader（按 SourceSpec::key() 去重），
+ * 绑定到同一输入源的视图共享同一份解码结果。Reader 分布在固定数量的读取线程上
+ * （QSettings `Scheduler/decode_threads`），每个输入源另有一个预取解码线程，
+ * 线程数不随视图数量增长。每个输入源有自己的信用池，只对绑定它的视图做背压。
+ *
+ * 所有接口都在GUI线程中调用。
+ */
+class DecodeService : public QObject {
+    Q_OBJECT
+public:
+    explicit DecodeService(QObject *parent = nullptr);
+    ~DecodeService();
+
+    /**
+     * @brief 把视图绑定到输入源；视图原来绑定的输入源没有其它视图使用时关闭
+     * @param source 为空（SOURCE_NONE）时等同于 unbind()
+     */
+    void bind(BasicViewWidget *view, const SourceSpec& source);
+
+    /**
+     * @brief 解除视图的绑定，视图销毁时自动调用
+     */
+    void unbind(BasicViewWidget *view);
+
+    bool isBound(BasicViewWidget *view) const { return m_bindings.contains(view); }
+
+    /**
+     * @brief 视图绑定的输入源，未绑定时返回空
+     */
+    SourceSpec sourceOf(BasicViewWidget *view) const;
+
+    int streamCount() const { return m_streams.size(); }
+    int threadCount() const { return m_threads.size(); }
+
+public slots:
+    /**
+     * @brief 播放/暂停所有输入源
+     */
+    void setPlaying(bool playing);
+
+    /**
+     * @brief 对所有文件源切换最大吞吐模式
+     */
+    void setMaxThroughput(bool enabled);
+
+signals:
+    /**
+     * @brief 某个输入源结束或出错
+     * @param source 输入源名称
+     * @param message 完成信息
+     */
+    void streamFinished(const QString &source, const QString &message);
+
+private:
+    struct Binding {
+        QString key;                        // 输入源键
+        FrameProcessor *processor = nullptr;    // 只用作信用池中的标识，视图销毁后不再访问
+        QMetaObject::Connection destroyed;  // 视图销毁时自动解绑
+    };
+
+    struct Stream {
+        SourceSpec source;
+        Reader *reader = nullptr;
+        FrameCreditPool *creditPool = nullptr;
+        QThread *thread = nullptr;
+        QVector<BasicViewWidget*> views;
+    };
+
+    Stream *openStream(const SourceSpec& source);
+    void closeStream(const QString& key);
+    void deliver(const QString& key, const Reader *reader, const SharedFrame& frame);
+    QThread *acquireThread();
+    void updatePrefixWindow();
+
+    QHash<QString, Stream*> m_streams;              // 输入源键 -> 输入源
+    QHash<BasicViewWidget*, Binding> m_bindings;    // 视图 -> 绑定的输入源
+    QVector<QThread*> m_threads;                    // 读取线程
+    QHash<QThread*, int> m_threadLoad;              // 各读取线程上的输入源数
+    int m_maxThreads;
+    int m_basePrefixWindow;
+    bool m_playing = false;
+    bool m_maxThroughput = false;
+};
@@ -72,6 +72,15 @@ void DetachedWindow::closeEvent(QCloseEvent *event)
     QWidget::closeEvent(event);
 }
 
+void DetachedWindow::changeEvent(QEvent *event)
+{
+    // 最小化/还原时通知主窗口调整该视图的调度优先级
+    if (event->type() == QEvent::WindowStateChange) {
+        emit minimizedChanged(this, isMinimized());
+    }
+    QWidget::changeEvent(event);
+}
+
 void DetachedWindow::mousePressEvent(QMouseEvent *event)
 {
     if (event->button() == Qt::LeftButton && m_titleBar && m_titleBar->geometry().contains(event->pos())) {
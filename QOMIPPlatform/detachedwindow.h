@@ -25,12 +25,14 @@ public:
 signals:
     void windowClosing(DetachedWindow *window);
     void returnToMainWindow(DetachedWindow *window);
+    void minimizedChanged(DetachedWindow *window, bool minimized);
     
 protected:
     void closeEvent(QCloseEvent *event) override;
     void mousePressEvent(QMouseEvent *event) override;
     void mouseMoveEvent(QMouseEvent *event) override;
     void keyPressEvent(QKeyEvent *event) override;
+    void changeEvent(QEvent *event) override;
     
 private:
     BasicViewWidget *m_widget;
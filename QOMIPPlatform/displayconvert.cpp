@@ -0,0 +1,286 @@
+#include "displayconvert.h"
+#include <opencv2/core/hal/intrin.hpp>
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+
+namespace DisplayConvert {
+
+namespace {
+
+// 每个像素写成一个 32 位字，字节顺序与 displayFormat() 一致
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+constexpr int kShiftB = 0;
+constexpr int kShiftG = 8;
+constexpr int kShiftR = 16;
+constexpr int kShiftA = 24;
+#else
+constexpr int kShiftR = 24;
+constexpr int kShiftG = 16;
+constexpr int kShiftB = 8;
+constexpr int kShiftA = 0;
+#endif
+
+// 线性映射 value * scale + offset，截断到 0..255
+struct Mapping {
+    float scale = 1.0f;
+    float offset = 0.0f;
+};
+
+Mapping mappingFor(const Range& range)
+{
+    Mapping mapping;
+    if (range.valid && range.max > range.min) {
+        mapping.scale = 255.0f / (range.max - range.min);
+        mapping.offset = -range.min * mapping.scale;
+    } else {
+        mapping.scale = 0.0f;   // 常数图像显示为黑色，与 normalize 一致
+    }
+    return mapping;
+}
+
+inline quint32 mapScalar(float value, const Mapping& mapping)
+{
+    // NaN 经两次比较后为 0
+    const float mapped = std::min(255.0f, std::max(0.0f, value * mapping.scale + mapping.offset));
+    return static_cast<quint32>(cvRound(mapped));
+}
+
+#if CV_SIMD128
+// 读取 8 个像素，按通道拆开为浮点：c[半组][通道]，每个半组 4 个像素
+template<typename T, int CN>
+inline void loadPixels(const T* src, cv::v_float32x4 (&c)[2][CN])
+{
+    using namespace cv;
+    if constexpr (std::is_same_v<T, float>) {
+        if constexpr (CN == 1) {
+            c[0][0] = v_load(src);
+            c[1][0] = v_load(src + 4);
+        } else if constexpr (CN == 3) {
+            v_load_deinterleave(src, c[0][0], c[0][1], c[0][2]);
+            v_load_deinterleave(src + 12, c[1][0], c[1][1], c[1][2]);
+        } else {
+            v_load_deinterleave(src, c[0][0], c[0][1], c[0][2], c[0][3]);
+            v_load_deinterleave(src + 16, c[1][0], c[1][1], c[1][2], c[1][3]);
+        }
+    } else {
+        v_uint16x8 v[CN];
+        if constexpr (CN == 1) {
+            v[0] = v_load(src);
+        } else if constexpr (CN == 3) {
+            v_load_deinterleave(src, v[0], v[1], v[2]);
+        } else {
+            v_load_deinterleave(src, v[0], v[1], v[2], v[3]);
+        }
+        for (int k = 0; k < CN; ++k) {
+            v_uint32x4 low, high;
+            v_expand(v[k], low, high);
+            c[0][k] = v_cvt_f32(v_reinterpret_as_s32(low));
+            c[1][k] = v_cvt_f32(v_reinterpret_as_s32(high));
+        }
+    }
+}
+#endif
+
+/*
+ * 一行：读取、映射、截断、打包为显示像素一次完成，observed 非空时同时统计颜色通道的范围。
+ * 4 通道图像的透明度不参与映射和统计。
+ */
+template<typename T, int CN>
+void convertRow(const uchar* srcRow, quint32* dst, int width, const Mapping& mapping, Range* observed)
+{
+    const T* src = reinterpret_cast<const T*>(srcRow);
+    constexpr int colors = CN == 1 ? 1 : 3;
+    float low = std::numeric_limits<float>::max();
+    float high = std::numeric_limits<float>::lowest();
+    int x = 0;
+
+#if CV_SIMD128
+    using namespace cv;
+    const v_float32x4 vscale = v_setall_f32(mapping.scale);
+    const v_float32x4 voffset = v_setall_f32(mapping.offset);
+    const v_float32x4 vzero = v_setzero_f32();
+    const v_float32x4 vwhite = v_setall_f32(255.0f);
+    const v_uint32x4 valpha = v_setall_u32(0xFFu << kShiftA);
+    v_float32x4 vlow = v_setall_f32(low);
+    v_float32x4 vhigh = v_setall_f32(high);
+    auto mapLanes = [&](const v_float32x4& value) {
+        // 参数顺序使 NaN 得到 0
+        const v_float32x4 mapped = v_min(v_max(v_muladd(value, vscale, voffset), vzero), vwhite);
+        return v_reinterpret_as_u32(v_round(mapped));
+    };
+
+    for (; x <= width - 8; x += 8) {
+        v_float32x4 c[2][CN];
+        loadPixels<T, CN>(src + x * CN, c);
+        for (int half = 0; half < 2; ++half) {
+            if (observed) {
+                for (int k = 0; k < colors; ++k) {
+                    vlow = v_min(c[half][k], vlow);     // NaN 不参与统计
+                    vhigh = v_max(c[half][k], vhigh);
+                }
+            }
+            v_uint32x4 pixel;
+            if constexpr (CN == 1) {
+                const v_uint32x4 gray = mapLanes(c[half][0]);
+                pixel = v_or(v_or(valpha, v_shl<kShiftB>(gray)), v_or(v_shl<kShiftG>(gray), v_shl<kShiftR>(gray)));
+            } else {
+                pixel = v_or(v_or(valpha, v_shl<kShiftB>(mapLanes(c[half][0]))),
+                             v_or(v_shl<kShiftG>(mapLanes(c[half][1])), v_shl<kShiftR>(mapLanes(c[half][2]))));
+            }
+            v_store(dst + x + half * 4, pixel);
+        }
+    }
+    if (observed) {
+        low = v_reduce_min(vlow);
+        high = v_reduce_max(vhigh);
+    }
+#endif
+
+    for (; x < width; ++x) {
+        const T* pixel = src + x * CN;
+        quint32 channel[3];
+        for (int k = 0; k < colors; ++k) {
+            const float value = static_cast<float>(pixel[k]);
+            if (observed) {
+                low = std::min(low, value);
+                high = std::max(high, value);
+            }
+            channel[k] = mapScalar(value, mapping);
+        }
+        if constexpr (CN == 1) {
+            channel[1] = channel[2] = channel[0];
+        }
+        dst[x] = (channel[0] << kShiftB) | (channel[1] << kShiftG) | (channel[2] << kShiftR) | (0xFFu << kShiftA);
+    }
+
+    if (observed) {
+        observed->min = std::min(observed->min, low);
+        observed->max = std::max(observed->max, high);
+    }
+}
+
+// 统计的初值：任何值都会更新它
+Range emptyRange()
+{
+    Range range;
+    range.min = std::numeric_limits<float>::max();
+    range.max = std::numeric_limits<float>::lowest();
+    return range;
+}
+
+using RowConverter = void (*)(const uchar*, quint32*, int, const Mapping&, Range*);
+
+RowConverter rowConverterFor(int depth, int channels)
+{
+    if (depth == CV_32F) {
+        return channels == 1 ? convertRow<float, 1> : channels == 3 ? convertRow<float, 3> : convertRow<float, 4>;
+    }
+    return channels == 1 ? convertRow<ushort, 1> : channels == 3 ? convertRow<ushort, 3> : convertRow<ushort, 4>;
+}
+
+// 逐行转换；两者都连续时按一行处理，减少行尾的标量处理
+void convertRows(const cv::Mat& src, cv::Mat& display, const Mapping& mapping, Range* observed)
+{
+    const RowConverter convert = rowConverterFor(src.depth(), src.channels());
+    const bool continuous = src.isContinuous() && display.isContinuous();
+    const int rows = continuous ? 1 : src.rows;
+    const int width = continuous ? src.rows * src.cols : src.cols;
+    for (int y = 0; y < rows; ++y) {
+        convert(src.ptr(y), display.ptr<quint32>(y), width, mapping, observed);
+    }
+}
+
+} // namespace
+
+Range RangeTracker::range() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_range;
+}
+
+void RangeTracker::update(const Range& observed)
+{
+    QMutexLocker locker(&m_mutex);
+    m_range = observed;
+}
+
+void RangeTracker::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    m_range = Range();
+}
+
+QImage::Format displayFormat()
+{
+    // 大端序下按字节顺序的格式绘制时由Qt转换，只作为兼容路径
+    return QSysInfo::ByteOrder == QSysInfo::LittleEndian ? QImage::Format_ARGB32_Premultiplied
+                                                         : QImage::Format_RGBA8888_Premultiplied;
+}
+
+bool convertForDisplay(const cv::Mat& image, cv::Mat& display, RangeTracker* tracker)
+{
+    const int channels = image.channels();
+    if (image.empty() || (channels != 1 && channels != 3 && channels != 4)) {
+        return false;
+    }
+
+    // 8 位：cvtColor 本身是向量化的单遍转换；小端序下不透明像素预乘后不变
+    const bool littleEndian = QSysInfo::ByteOrder == QSysInfo::LittleEndian;
+    if (image.depth() == CV_8U) {
+        switch (channels) {
+        case 1:
+            cv::cvtColor(image, display, littleEndian ? cv::COLOR_GRAY2BGRA : cv::COLOR_GRAY2RGBA);
+            break;
+        case 3:
+            cv::cvtColor(image, display, littleEndian ? cv::COLOR_BGR2BGRA : cv::COLOR_BGR2RGBA);
+            break;
+        default:
+            if (littleEndian) {
+                cv::cvtColor(image, display, cv::COLOR_RGBA2mRGBA);     // 预乘与通道顺序无关
+            } else {
+                cv::Mat rgba;
+                cv::cvtColor(image, rgba, cv::COLOR_BGRA2RGBA);
+                cv::cvtColor(rgba, display, cv::COLOR_RGBA2mRGBA);
+            }
+            break;
+        }
+        return true;
+    }
+
+    cv::Mat src = image;
+    if (src.depth() != CV_16U && src.depth() != CV_32F) {
+        image.convertTo(src, CV_32F);   // 少见的深度：先转为浮点
+    }
+    display.create(src.size(), CV_8UC4);
+
+    if (src.depth() == CV_16U) {
+        Mapping mapping;
+        mapping.scale = 255.0f / 65535.0f;
+        convertRows(src, display, mapping, nullptr);
+        return true;
+    }
+
+    // 浮点：沿用上一帧的范围，同一遍统计本帧范围
+    Range range = tracker ? tracker->range() : Range();
+    if (!range.valid) {
+        // 没有可沿用的范围（第一帧或未使用 tracker）：先统计一遍，统计时写出的像素随后被覆盖
+        range = emptyRange();
+        convertRows(src, display, Mapping(), &range);
+        range.valid = range.min <= range.max;
+        convertRows(src, display, mappingFor(range), nullptr);
+        if (tracker && range.valid) {
+            tracker->update(range);
+        }
+        return true;
+    }
+    Range observed = emptyRange();
+    convertRows(src, display, mappingFor(range), &observed);
+    observed.valid = observed.min <= observed.max;
+    if (observed.valid) {
+        tracker->update(observed);
+    }
+    return true;
+}
+
+} // namespace DisplayConvert
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <QImage>
+#include <QMutex>
+#include <opencv2/opencv.hpp>
+
+/**
+ * @brief 处理结果到显示图像的转换
+ *
+ * 输出为 displayFormat() 布局的 CV_8UC4：小端序下内存顺序 B,G,R,A，
+ * 即 QImage::Format_ARGB32_Premultiplied，是 QPainter::drawImage 的快速路径。
+ *
+ * 16 位和浮点图像（任意 1/3/4 通道）由单遍的向量化内核直接写出显示像素，
+ * 不经过 normalize / convertTo / cvtColor 的中间结果；8 位图像使用 cvtColor。
+ */
+namespace DisplayConvert {
+
+/**
+ * @brief 取值范围
+ */
+struct Range {
+    float min = 0.0f;
+    float max = 0.0f;
+    bool valid = false;
+};
+
+/**
+ * @class RangeTracker
+ * @brief 跨帧沿用浮点图像的取值范围（线程安全）
+ *
+ * 每帧按上一帧的范围映射到 0..255，同时在同一遍中统计本帧的范围供下一帧使用，
+ * 浮点结果的可视化因此只需要一遍。第一帧没有范围时先统计一遍。
+ */
+class RangeTracker {
+public:
+    Range range() const;
+    void update(const Range& observed);
+    void reset();
+
+private:
+    mutable QMutex m_mutex;
+    Range m_range;
+};
+
+/**
+ * @brief convertForDisplay() 输出对应的 QImage 格式，小端序下为 ARGB32_Premultiplied
+ */
+QImage::Format displayFormat();
+
+/**
+ * @brief 把 1、3、4 通道的图像转换为 displayFormat() 布局的 CV_8UC4（线程安全）
+ *
+ * - 8 位：按原值，4 通道按透明度预乘
+ * - 16 位无符号：0..65535 映射到 0..255
+ * - 浮点：最小/最大值拉伸到 0..255；tracker 非空时沿用上一帧的范围并记录本帧范围，
+ *   否则先统计本帧范围
+ * - 其它深度先转换为浮点
+ * 非 8 位的 4 通道图像忽略透明度，按不透明显示。
+ *
+ * @param image 要转换的图像，BGR 顺序
+ * @param display 输出，尺寸和类型相同时直接写入已有缓冲
+ * @param tracker 浮点图像的跨帧范围，可以为空
+ */
+bool convertForDisplay(const cv::Mat& image, cv::Mat& display, RangeTracker* tracker = nullptr);
+
+} // namespace DisplayConvert
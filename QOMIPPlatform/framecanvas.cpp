@@ -0,0 +1,323 @@
+#include "framecanvas.h"
+#include "taskscheduler.h"
+#include <QDebug>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QThread>
+#include <QTimer>
+#include <QWheelEvent>
+#include <cmath>
+
+namespace {
+
+// QImage 释放最后一个引用时调用：交还缓冲的引用，池中的缓冲随之可以复用
+void releaseBuffer(void *info)
+{
+    delete static_cast<cv::Mat*>(info);
+}
+
+} // namespace
+
+FrameCanvas::FrameCanvas(QWidget *parent)
+    : QWidget(parent)
+{
+    // 每次绘制都覆盖整个控件，不需要Qt先擦除背景
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setMouseTracking(false);
+}
+
+FrameCanvas::~FrameCanvas()
+{
+    // 等待正在进行的重新转换结束，它还在使用视口和缓冲池
+    QMutexLocker locker(&m_refreshMutex);
+    while (m_refreshing) {
+        m_refreshDone.wait(&m_refreshMutex);
+    }
+}
+
+QRectF FrameCanvas::placement(const cv::Size &source, const View &view)
+{
+    const double fit = qMin(view.size.width() / source.width,
+                            view.size.height() / source.height);
+    const QSizeF size(source.width * fit * view.zoom, source.height * fit * view.zoom);
+    const QPointF center = QPointF(view.size.width() / 2.0, view.size.height() / 2.0) + view.pan;
+    return QRectF(center.x() - size.width() / 2.0, center.y() - size.height() / 2.0,
+                  size.width(), size.height());
+}
+
+FrameCanvas::Prepared FrameCanvas::prepareImage(const cv::Mat &image)
+{
+    Prepared prepared;
+    prepared.source = image;
+    if (image.empty()) {
+        return prepared;
+    }
+
+    View view;
+    {
+        QMutexLocker locker(&m_viewMutex);
+        view = m_view;
+    }
+    prepared.viewSerial = view.serial;
+    if (!view.shown) {
+        return prepared;    // 不可见时不转换，显示时由保留的原图转换
+    }
+
+    // 只转换可见区域；缩小显示时直接缩小到屏幕上的像素尺寸，控件尚无尺寸时按原图转换
+    cv::Rect region(0, 0, image.cols, image.rows);
+    cv::Size target = region.size();
+    if (!view.size.isEmpty()) {
+        const QRectF full = placement(image.size(), view);
+        const QRectF visible = full.intersected(QRectF(QPointF(0, 0), view.size));
+        if (visible.isEmpty()) {
+            return prepared;    // 图像完全移出了控件
+        }
+        const double scale = full.width() / image.cols;     // 每个原图像素占的逻辑像素
+        const int x0 = qBound(0, static_cast<int>(std::floor((visible.left() - full.left()) / scale)), image.cols - 1);
+        const int y0 = qBound(0, static_cast<int>(std::floor((visible.top() - full.top()) / scale)), image.rows - 1);
+        const int x1 = qBound(x0 + 1, static_cast<int>(std::ceil((visible.right() - full.left()) / scale)), image.cols);
+        const int y1 = qBound(y0 + 1, static_cast<int>(std::ceil((visible.bottom() - full.top()) / scale)), image.rows);
+        region = cv::Rect(x0, y0, x1 - x0, y1 - y0);
+        target = region.size();
+
+        const double pixels = scale * view.devicePixelRatio;  // 每个原图像素占的屏幕像素
+        if (pixels < 1.0) {
+            target = cv::Size(qMax(1, static_cast<int>(std::ceil(region.width * pixels))),
+                              qMax(1, static_cast<int>(std::ceil(region.height * pixels))));
+        }
+    }
+    prepared.region = QRect(region.x, region.y, region.width, region.height);
+
+    cv::Mat src = image(region);
+    if (src.size() != target) {
+        cv::Mat scaled;
+        cv::resize(src, scaled, target, 0.0, 0.0, cv::INTER_AREA);
+        src = scaled;
+    }
+    cv::Mat buffer = acquireBuffer(src.size());
+    if (!DisplayConvert::convertForDisplay(src, buffer, &m_range)) {
+        return prepared;
+    }
+
+    // QImage 持有缓冲的一个引用，引用全部释放后由 releaseBuffer 交还
+    prepared.image = QImage(buffer.data, buffer.cols, buffer.rows, static_cast<int>(buffer.step),
+                            DisplayConvert::displayFormat(), releaseBuffer, new cv::Mat(buffer));
+    return prepared;
+}
+
+cv::Mat FrameCanvas::acquireBuffer(const cv::Size &size)
+{
+    QMutexLocker locker(&m_poolMutex);
+
+    // 只有池本身引用的缓冲才能复用：显示中、邮箱中的图像都持有引用
+    for (cv::Mat &candidate : m_pool) {
+        if (candidate.u && candidate.u->refcount == 1) {
+            candidate.create(size, CV_8UC4);    // 尺寸不变时不重新分配
+            return candidate;
+        }
+    }
+
+    // 显示中一张、邮箱中一张，其余是正在转换的结果
+    const size_t limit = static_cast<size_t>(QThread::idealThreadCount()) + 2;
+    cv::Mat buffer(size, CV_8UC4);
+    if (m_pool.size() < limit) {
+        m_pool.push_back(buffer);
+    }
+    return buffer;
+}
+
+void FrameCanvas::setImage(const Prepared &prepared)
+{
+    m_prepared = prepared;
+    if (isStale()) {
+        scheduleRefresh();  // 转换之后视口又变了
+    }
+    update();
+}
+
+void FrameCanvas::setSource(const cv::Mat &image)
+{
+    // 控件可见后视口版本总大于0，尚未转换的原图按视口已变化处理
+    Prepared prepared;
+    prepared.source = image;
+    setImage(prepared);
+}
+
+void FrameCanvas::resetView()
+{
+    setView(1.0, QPointF());
+}
+
+void FrameCanvas::setView(double zoom, const QPointF &pan)
+{
+    {
+        QMutexLocker locker(&m_viewMutex);
+        m_view.zoom = zoom;
+        m_view.pan = pan;
+        ++m_view.serial;
+    }
+    scheduleRefresh();
+    update();
+}
+
+void FrameCanvas::scheduleRefresh()
+{
+    if (m_refreshPending) {
+        return;
+    }
+    m_refreshPending = true;
+    QTimer::singleShot(0, this, &FrameCanvas::refresh);
+}
+
+void FrameCanvas::refresh()
+{
+    if (!isStale()) {
+        m_refreshPending = false;
+        return;
+    }
+    {
+        QMutexLocker locker(&m_refreshMutex);
+        m_refreshing = true;
+    }
+
+    // GUI线程不转换像素：原图只读共享，转换期间当前图像照常绘制
+    const cv::Mat source = m_prepared.source;
+    TaskScheduler::instance().submit([this, source]() {
+        Prepared prepared;      // 失败时为空
+        try {
+            prepared = prepareImage(source);
+        } catch (const std::exception& e) {
+            qWarning() << "[FrameCanvas] 显示转换失败:" << e.what();
+        }
+        QMutexLocker locker(&m_refreshMutex);
+        QMetaObject::invokeMethod(this, [this, prepared]() {
+            finishRefresh(prepared);
+        }, Qt::QueuedConnection);
+        m_refreshing = false;
+        m_refreshDone.wakeAll();
+    });
+}
+
+void FrameCanvas::finishRefresh(const Prepared &prepared)
+{
+    m_refreshPending = false;
+    if (prepared.isNull()) {
+        return;     // 转换失败，等下一次视口变化或新图像时再转换
+    }
+    // 转换期间显示了新的图像时，新图像自己按视口转换过，不用旧图的结果覆盖
+    if (prepared.source.data == m_prepared.source.data) {
+        m_prepared = prepared;
+        update();
+    }
+    if (isStale()) {
+        scheduleRefresh();  // 转换期间视口又变了
+    }
+}
+
+bool FrameCanvas::isStale() const
+{
+    return !m_prepared.isNull() && m_view.shown && m_prepared.viewSerial != m_view.serial;
+}
+
+void FrameCanvas::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().color(QPalette::Base));
+    if (m_prepared.image.isNull()) {
+        return;
+    }
+    // 图像只覆盖原图的 region 区域，按整幅原图的位置换算绘制区域
+    const QRectF full = placement(m_prepared.source.size(), m_view);
+    const double scale = full.width() / m_prepared.source.cols;
+    const QRect &region = m_prepared.region;
+    const QRectF target(full.left() + region.x() * scale, full.top() + region.y() * scale,
+                        region.width() * scale, region.height() * scale);
+    // 不开启平滑缩放：图像已按屏幕尺寸转换，ARGB32_Premultiplied 走光栅引擎的快速路径
+    painter.drawImage(target, m_prepared.image);
+}
+
+void FrameCanvas::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    {
+        QMutexLocker locker(&m_viewMutex);
+        m_view.size = QSizeF(size());
+        m_view.devicePixelRatio = devicePixelRatioF();
+        ++m_view.serial;
+    }
+    scheduleRefresh();
+}
+
+void FrameCanvas::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    setShown(true);
+}
+
+void FrameCanvas::hideEvent(QHideEvent *event)
+{
+    QWidget::hideEvent(event);
+    setShown(false);
+}
+
+void FrameCanvas::setShown(bool shown)
+{
+    {
+        QMutexLocker locker(&m_viewMutex);
+        m_view.shown = shown;
+        ++m_view.serial;
+    }
+    if (shown) {
+        scheduleRefresh();
+    }
+}
+
+void FrameCanvas::wheelEvent(QWheelEvent *event)
+{
+    // 以光标为中心缩放：光标下的图像点保持不动
+    const double factor = event->angleDelta().y() > 0 ? 1.15 : 1.0 / 1.15;
+    const double zoom = qBound(0.1, m_view.zoom * factor, 50.0);
+    const QPointF anchor = event->position() - QRectF(rect()).center();
+    setView(zoom, anchor - (anchor - m_view.pan) * (zoom / m_view.zoom));
+    event->accept();
+}
+
+void FrameCanvas::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton) {
+        m_dragging = true;
+        m_dragStart = event->pos();
+        setCursor(Qt::ClosedHandCursor);
+        event->accept();
+        return;
+    }
+    QWidget::mousePressEvent(event);
+}
+
+void FrameCanvas::mouseMoveEvent(QMouseEvent *event)
+{
+    if (m_dragging) {
+        setView(m_view.zoom, m_view.pan + (event->pos() - m_dragStart));
+        m_dragStart = event->pos();
+        event->accept();
+        return;
+    }
+    QWidget::mouseMoveEvent(event);
+}
+
+void FrameCanvas::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton && m_dragging) {
+        m_dragging = false;
+        unsetCursor();
+        event->accept();
+        return;
+    }
+    QWidget::mouseReleaseEvent(event);
+}
+
+void FrameCanvas::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    resetView();
+    event->accept();
+}
@@ -0,0 +1,154 @@
+#ifndef FRAMECANVAS_H
+#define FRAMECANVAS_H
+
+#include <QImage>
+#include <QMutex>
+#include <QPointF>
+#include <QRect>
+#include <QWaitCondition>
+#include <QWidget>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "displayconvert.h"
+
+/**
+ * @class FrameCanvas
+ * @brief 直接绘制处理结果的显示控件
+ *
+ * 处理线程调用 prepareImage() 用 DisplayConvert 把结果转换为 ARGB32_Premultiplied（drawImage 的快速路径），
+ * 像素写入复用池中的缓冲，QImage 只引用缓冲、不拷贝，最后一个引用释放时缓冲回到池中。
+ * GUI 线程的 setImage() 只保存引用，paintEvent 直接 drawImage，不再经过 QPixmap，
+ * 也不做任何像素转换或拷贝。
+ *
+ * 转换按视口进行：只转换可见的原图区域，并用面积插值缩小到屏幕上的实际像素尺寸，
+ * 放大到超过 1:1 时才按原始分辨率转换可见区域。视口（控件尺寸、缩放、平移）变化后
+ * 由保留的原图在调度器的工作线程中重新转换，完成后回到GUI线程显示；控件不可见时
+ * （例如不在当前标签页）不转换。
+ *
+ * 图像按比例适配控件，滚轮以光标为中心缩放，左键拖动平移，双击还原。
+ */
+class FrameCanvas : public QWidget
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief 按视口转换好的显示图像
+     */
+    struct Prepared {
+        QImage  image;          ///< 可直接绘制的图像，覆盖原图的 region 区域
+        cv::Mat source;         ///< 转换所用的原图（只读共享），视口变化时重新转换
+        QRect   region;         ///< image 对应的原图区域
+        quint64 viewSerial = 0; ///< 转换时的视口版本，0 表示尚未转换
+
+        bool isNull() const { return source.empty(); }
+    };
+
+    explicit FrameCanvas(QWidget *parent = nullptr);
+    ~FrameCanvas() override;
+
+    /**
+     * @brief 按当前视口把处理结果转换为可直接绘制的图像（线程安全，在处理线程中调用）
+     * @param image 8/16位或浮点的1、3、4通道图像，BGR 顺序
+     * @return 转换失败时 image 为空
+     */
+    Prepared prepareImage(const cv::Mat &image);
+
+    /**
+     * @brief 显示已转换的图像（GUI线程），只保存引用
+     *
+     * 转换之后视口又发生了变化时，按新视口重新转换一次。
+     */
+    void setImage(const Prepared &prepared);
+
+    /**
+     * @brief 显示未转换的原图（GUI线程），像素在工作线程中按当前视口转换
+     */
+    void setSource(const cv::Mat &image);
+
+    /**
+     * @brief 恢复为适配控件的缩放，取消平移
+     */
+    void resetView();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+
+private:
+    /**
+     * @brief 视口：处理线程按它决定转换区域和尺寸
+     */
+    struct View {
+        QSizeF  size;               ///< 控件尺寸（逻辑像素）
+        qreal   devicePixelRatio = 1.0;
+        double  zoom = 1.0;         ///< 相对适配大小的缩放
+        QPointF pan;                ///< 平移（逻辑像素）
+        bool    shown = false;      ///< 控件可见
+        quint64 serial = 0;         ///< 每次变化加一
+    };
+
+    /**
+     * @brief 整幅原图在控件中的位置
+     */
+    static QRectF placement(const cv::Size &source, const View &view);
+
+    /**
+     * @brief 修改视口（GUI线程），并安排按新视口重新转换
+     */
+    void setView(double zoom, const QPointF &pan);
+
+    /**
+     * @brief 记录可见性（GUI线程），重新显示时按当前视口转换
+     */
+    void setShown(bool shown);
+
+    /**
+     * @brief 合并同一轮事件中的多次视口变化，只重新转换一次
+     */
+    void scheduleRefresh();
+
+    /**
+     * @brief 在工作线程中按当前视口重新转换保留的原图，完成后由 finishRefresh() 显示
+     */
+    void refresh();
+
+    /**
+     * @brief 显示重新转换的结果（GUI线程）；期间已换了新图像时丢弃
+     */
+    void finishRefresh(const Prepared &prepared);
+
+    /**
+     * @brief 当前图像是否按旧视口转换、需要重新转换
+     */
+    bool isStale() const;
+
+    /**
+     * @brief 从复用池取一块当前没有被任何 QImage 引用的缓冲
+     */
+    cv::Mat acquireBuffer(const cv::Size &size);
+
+    Prepared m_prepared;            // 当前显示的图像（引用池中的缓冲）
+    QPoint m_dragStart;
+    bool m_dragging = false;
+    bool m_refreshPending = false;  // 已安排或正在重新转换，完成前不再安排
+
+    QMutex m_refreshMutex;
+    QWaitCondition m_refreshDone;
+    bool m_refreshing = false;      // 工作线程中的转换还在使用本对象，析构时等待
+
+    mutable QMutex m_viewMutex;     // 处理线程读取视口，GUI线程修改
+    View m_view;                    // GUI线程读取时不需要加锁
+
+    QMutex m_poolMutex;
+    std::vector<cv::Mat> m_pool;    // 显示缓冲复用池（CV_8UC4）
+    DisplayConvert::RangeTracker m_range;   // 浮点结果跨帧沿用的取值范围
+};
+
+#endif // FRAMECANVAS_H
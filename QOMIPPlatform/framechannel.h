@@ -0,0 +1,259 @@
+#pragma once
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <QDeadlineTimer>
+#include <QtGlobal>
+#include <atomic>
+#include <deque>
+#include <utility>
+
+/**
+ * @brief 队列满时的丢帧策略
+ */
+enum class FrameDropPolicy {
+    DropOldest,     ///< 丢弃队首最旧的帧，保证显示最新画面（默认）
+    DropNewest,     ///< 丢弃新到达的帧，保证已排队帧按序处理
+    Block           ///< 生产者阻塞等待空位，不丢帧
+};
+
+/**
+ * @brief 帧通道统计计数（快照）
+ */
+struct FrameChannelStats {
+    quint64 enqueued = 0;   ///< 成功入队的帧数
+    quint64 dropped = 0;    ///< 因队列满被丢弃的帧数
+    quint64 processed = 0;  ///< 消费者处理完成的帧数
+    int queued = 0;         ///< 当前队列中的帧数
+    int capacity = 0;       ///< 队列容量
+};
+
+/**
+ * @class FrameChannel
+ * @brief 有界单生产者/单消费者帧通道
+ *
+ * 所有队列操作都在互斥锁内完成；队列为空时消费者在条件变量上休眠，
+ * 不再空转占用CPU。队列满时按 FrameDropPolicy 处理新帧。
+ */
+template <typename T>
+class FrameChannel {
+public:
+    explicit FrameChannel(int capacity = 4,
+                          FrameDropPolicy policy = FrameDropPolicy::DropOldest)
+        : m_capacity(qMax(1, capacity)), m_policy(policy) {}
+
+    FrameChannel(const FrameChannel &) = delete;
+    FrameChannel &operator=(const FrameChannel &) = delete;
+
+    void setCapacity(int capacity)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_capacity = qMax(1, capacity);
+        // 缩小容量时按丢帧策略裁剪已有队列
+        while (static_cast<int>(m_queue.size()) > m_capacity) {
+            m_queue.pop_front();
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        m_notFull.wakeAll();
+    }
+
+    int capacity() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_capacity;
+    }
+
+    void setDropPolicy(FrameDropPolicy policy)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_policy = policy;
+        m_notFull.wakeAll();
+    }
+
+    FrameDropPolicy dropPolicy() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_policy;
+    }
+
+    /**
+     * @brief 打开通道，允许入队
+     */
+    void open()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_closed = false;
+    }
+
+    /**
+     * @brief 关闭通道：拒绝新帧并唤醒所有等待者
+     */
+    void close()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_closed = true;
+        m_notEmpty.wakeAll();
+        m_notFull.wakeAll();
+    }
+
+    bool isClosed() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_closed;
+    }
+
+    /**
+     * @brief 入队一帧
+     * @return 帧是否进入队列（被丢弃或通道已关闭时返回false）
+     */
+    bool push(T item)
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_closed) {
+            return false;
+        }
+
+        if (static_cast<int>(m_queue.size()) >= m_capacity) {
+            switch (m_policy) {
+            case FrameDropPolicy::DropOldest:
+                m_queue.pop_front();
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                break;
+            case FrameDropPolicy::DropNewest:
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            case FrameDropPolicy::Block:
+                while (!m_closed && m_policy == FrameDropPolicy::Block
+                       && static_cast<int>(m_queue.size()) >= m_capacity) {
+                    m_notFull.wait(&m_mutex);
+                }
+                if (m_closed) {
+                    return false;
+                }
+                // 等待期间策略被修改为丢帧策略时，腾出一个位置
+                if (static_cast<int>(m_queue.size()) >= m_capacity) {
+                    if (m_policy == FrameDropPolicy::DropNewest) {
+                        m_dropped.fetch_add(1, std::memory_order_relaxed);
+                        return false;
+                    }
+                    m_queue.pop_front();
+                    m_dropped.fetch_add(1, std::memory_order_relaxed);
+                }
+                break;
+            }
+        }
+
+        m_queue.push_back(std::move(item));
+        m_enqueued.fetch_add(1, std::memory_order_relaxed);
+        m_notEmpty.wakeOne();
+        return true;
+    }
+
+    /**
+     * @brief 取出一帧，队列为空时休眠等待
+     * @param out 输出帧
+     * @param timeoutMs 最长等待时间，-1表示一直等待
+     * @return 取到帧返回true；超时或通道关闭返回false
+     */
+    bool pop(T &out, int timeoutMs = -1)
+    {
+        QMutexLocker locker(&m_mutex);
+        const QDeadlineTimer deadline = timeoutMs < 0
+                ? QDeadlineTimer(QDeadlineTimer::Forever)
+                : QDeadlineTimer(timeoutMs);
+        while (m_queue.empty()) {
+            if (m_closed) {
+                return false;
+            }
+            if (!m_notEmpty.wait(&m_mutex, deadline)) {
+                if (m_queue.empty()) {
+                    return false;   // 超时
+                }
+                break;
+            }
+        }
+
+        out = std::move(m_queue.front());
+        m_queue.pop_front();
+        m_notFull.wakeOne();
+        return true;
+    }
+
+    /**
+     * @brief 非阻塞取帧
+     */
+    bool tryPop(T &out)
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_queue.empty()) {
+            return false;
+        }
+        out = std::move(m_queue.front());
+        m_queue.pop_front();
+        m_notFull.wakeOne();
+        return true;
+    }
+
+    /**
+     * @brief 清空队列（不计入丢帧数）
+     */
+    void clear()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_queue.clear();
+        m_notFull.wakeAll();
+    }
+
+    int size() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return static_cast<int>(m_queue.size());
+    }
+
+    bool isEmpty() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_queue.empty();
+    }
+
+    /**
+     * @brief 消费者处理完一帧后调用，用于统计
+     */
+    void markProcessed()
+    {
+        m_processed.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    FrameChannelStats stats() const
+    {
+        FrameChannelStats s;
+        s.enqueued = m_enqueued.load(std::memory_order_relaxed);
+        s.dropped = m_dropped.load(std::memory_order_relaxed);
+        s.processed = m_processed.load(std::memory_order_relaxed);
+        QMutexLocker locker(&m_mutex);
+        s.queued = static_cast<int>(m_queue.size());
+        s.capacity = m_capacity;
+        return s;
+    }
+
+    void resetStats()
+    {
+        m_enqueued.store(0, std::memory_order_relaxed);
+        m_dropped.store(0, std::memory_order_relaxed);
+        m_processed.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    mutable QMutex m_mutex;
+    QWaitCondition m_notEmpty;
+    QWaitCondition m_notFull;
+    std::deque<T> m_queue;
+    int m_capacity;
+    FrameDropPolicy m_policy;
+    bool m_closed = false;
+
+    std::atomic<quint64> m_enqueued{0};
+    std::atomic<quint64> m_dropped{0};
+    std::atomic<quint64> m_processed{0};
+};
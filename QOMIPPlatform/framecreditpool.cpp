@@ -0,0 +1,116 @@
+#include "framecreditpool.h"
+#include "frameprocessor.h"
+
+FrameCreditPool::FrameCreditPool(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void FrameCreditPool::addConsumer(FrameProcessor *consumer)
+{
+    if (!consumer) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_credits.insert(consumer, consumer->availableCredits());
+    }
+
+    // 直接连接：在处理线程中更新计数，不经过事件循环
+    connect(consumer, &FrameProcessor::creditsChanged, this, [this, consumer](int credits) {
+        setCredits(consumer, credits);
+    }, Qt::DirectConnection);
+
+    // 只用地址注销，不再访问正在析构的对象
+    connect(consumer, &QObject::destroyed, this, [this, consumer]() {
+        removeConsumer(consumer);
+    }, Qt::DirectConnection);
+}
+
+void FrameCreditPool::removeConsumer(const QObject *consumer)
+{
+    bool wasSaturated = false;
+    bool nowAvailable = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        wasSaturated = !hasCreditLocked();
+        m_credits.remove(consumer);
+        nowAvailable = hasCreditLocked();
+    }
+
+    // 移除最后一个饱和的处理器后读取端可以恢复
+    if (wasSaturated && nowAvailable) {
+        emit creditsAvailable();
+    }
+}
+
+bool FrameCreditPool::hasCredit() const
+{
+    QMutexLocker locker(&m_mutex);
+    return hasCreditLocked();
+}
+
+bool FrameCreditPool::hasCreditLocked() const
+{
+    if (m_credits.isEmpty()) {
+        return true;
+    }
+    for (int credits : m_credits) {
+        if (credits - m_inTransit > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FrameCreditPool::reserveFrame()
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_inTransit;
+}
+
+void FrameCreditPool::releaseFrame()
+{
+    bool wasSaturated = false;
+    bool nowAvailable = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_inTransit == 0) {
+            return;
+        }
+        wasSaturated = !hasCreditLocked();
+        --m_inTransit;
+        nowAvailable = hasCreditLocked();
+    }
+
+    if (wasSaturated && nowAvailable) {
+        emit creditsAvailable();
+    }
+}
+
+int FrameCreditPool::consumerCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_credits.size();
+}
+
+void FrameCreditPool::setCredits(const QObject *consumer, int credits)
+{
+    bool wasSaturated = false;
+    bool nowAvailable = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_credits.find(consumer);
+        if (it == m_credits.end()) {
+            return;
+        }
+        wasSaturated = !hasCreditLocked();
+        it.value() = credits;
+        nowAvailable = hasCreditLocked();
+    }
+
+    if (wasSaturated && nowAvailable) {
+        emit creditsAvailable();
+    }
+}
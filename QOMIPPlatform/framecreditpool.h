@@ -0,0 +1,67 @@
+#pragma once
+
+#include <QObject>
+#include <QMutex>
+#include <QHash>
+
+class FrameProcessor;
+
+/**
+ * @class FrameCreditPool
+ * @brief 读取端与处理端之间的信用计数（背压）
+ *
+ * 每个 FrameProcessor 报告自己还能接收的帧数（信用），Reader 在解码前查询：
+ * 至少有一个处理器还有信用时才解码并发送，否则只 grab() 跳过这一帧，
+ * 避免解码出的帧随后在处理队列中被丢弃。已发出但尚未分发到处理器的帧
+ * 计为在途帧，会占用所有处理器的信用。
+ *
+ * 信用更新来自各处理线程，查询来自读取线程，所有接口都是线程安全的。
+ */
+class FrameCreditPool : public QObject {
+    Q_OBJECT
+public:
+    explicit FrameCreditPool(QObject *parent = nullptr);
+
+    /**
+     * @brief 注册处理器；处理器销毁时自动注销
+     */
+    void addConsumer(FrameProcessor *consumer);
+
+    /**
+     * @brief 注销处理器
+     */
+    void removeConsumer(const QObject *consumer);
+
+    /**
+     * @brief 是否至少有一个处理器还能接收新帧
+     *
+     * 没有注册任何处理器时返回true，保持不受背压控制的行为。
+     */
+    bool hasCredit() const;
+
+    /**
+     * @brief 读取端发出一帧前调用
+     */
+    void reserveFrame();
+
+    /**
+     * @brief 帧分发给所有处理器后调用
+     */
+    void releaseFrame();
+
+    int consumerCount() const;
+
+signals:
+    /**
+     * @brief 由全部饱和变为有处理器可接收新帧时发出
+     */
+    void creditsAvailable();
+
+private:
+    void setCredits(const QObject *consumer, int credits);
+    bool hasCreditLocked() const;
+
+    mutable QMutex m_mutex;
+    QHash<const QObject*, int> m_credits;   // 各处理器的剩余信用
+    int m_inTransit = 0;                    // 已发出但尚未分发的帧数
+};
@@ -0,0 +1,282 @@
+#include "frameprefetcher.h"
+#include "framecreditpool.h"
+#include <QDebug>
+
+FramePrefetcher::FramePrefetcher(std::unique_ptr<FrameSource> source, int capacity,
+                                 FrameCreditPool *creditPool)
+    : m_source(std::move(source))
+    , m_creditPool(creditPool)
+    , m_capacity(m_source->isLive() ? 1 : qMax(1, capacity))
+    , m_live(m_source->isLive())
+    , m_description(m_source->description())
+{
+}
+
+FramePrefetcher::~FramePrefetcher()
+{
+    requestStop();
+    if (m_thread) {
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+}
+
+void FramePrefetcher::start()
+{
+    if (m_thread) {
+        return;
+    }
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->setObjectName("FramePrefetcher");
+    m_thread->start();
+}
+
+void FramePrefetcher::requestStop()
+{
+    QMutexLocker locker(&m_mutex);
+    m_stopRequested = true;
+    m_notify = nullptr;     // 停止后不再回调，调用方可能先于本对象销毁
+    m_creditPool = nullptr; // 信用池同样可能先于本对象销毁
+    m_wakeup.wakeAll();
+    m_source->requestStop(); // 唤醒阻塞在输入源中的解码线程
+}
+
+bool FramePrefetcher::tryPop(PrefetchedFrame& frame)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_ring.empty()) {
+        return false;
+    }
+    frame = std::move(m_ring.front());
+    m_ring.pop_front();
+    m_wakeup.wakeAll();
+    return true;
+}
+
+void FramePrefetcher::requestFrame()
+{
+    QMutexLocker locker(&m_mutex);
+    m_frameRequested = true;
+}
+
+bool FramePrefetcher::peekTimestamp(qint64& timestampMs) const
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_ring.empty()) {
+        return false;
+    }
+    timestampMs = m_ring.front().timestampMs;
+    return true;
+}
+
+void FramePrefetcher::rewind()
+{
+    QMutexLocker locker(&m_mutex);
+    m_rewindRequested = true;
+    m_discardBefore = -1;
+    m_ring.clear();
+    m_wakeup.wakeAll();
+}
+
+void FramePrefetcher::seek(qint64 timestampMs, bool keyframeOnly)
+{
+    QMutexLocker locker(&m_mutex);
+    m_seekRequested = true;
+    m_seekTarget = timestampMs;
+    m_seekKeyframeOnly = keyframeOnly;
+    m_discardBefore = -1;
+    m_ring.clear();
+    m_wakeup.wakeAll();
+}
+
+FramePrefetcher::State FramePrefetcher::state() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_state;
+}
+
+int FramePrefetcher::buffered() const
+{
+    QMutexLocker locker(&m_mutex);
+    return static_cast<int>(m_ring.size());
+}
+
+double FramePrefetcher::nominalFps() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_fps;
+}
+
+qint64 FramePrefetcher::durationMs() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_durationMs;
+}
+
+void FramePrefetcher::setDiscardBefore(qint64 mediaMs)
+{
+    QMutexLocker locker(&m_mutex);
+    m_discardBefore = mediaMs;
+}
+
+quint64 FramePrefetcher::lateGrabbed() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_lateGrabbed;
+}
+
+void FramePrefetcher::setSkipWhenSaturated(bool skip)
+{
+    QMutexLocker locker(&m_mutex);
+    m_skipWhenSaturated = skip;
+}
+
+void FramePrefetcher::setNotifyCallback(std::function<void()> callback)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_stopRequested) {
+        m_notify = std::move(callback);
+    }
+}
+
+void FramePrefetcher::notifyLocked()
+{
+    // 在锁内调用，保证 requestStop() 返回后不会再有回调
+    if (m_notify) {
+        m_notify();
+    }
+}
+
+void FramePrefetcher::run()
+{
+    const bool opened = m_source->open();
+    {
+        QMutexLocker locker(&m_mutex);
+        m_state = opened ? State::Running : State::Failed;
+        m_fps = opened ? m_source->nominalFps() : 0.0;
+        m_durationMs = opened ? m_source->durationMs() : -1;
+        notifyLocked();
+        if (!opened) {
+            return;
+        }
+    }
+
+    // 解码落后判定阈值：一帧的时长，帧率未知时按30fps计
+    const qint64 frameDurationMs = qMax<qint64>(1, qRound(1000.0 / (m_fps > 0.0 ? m_fps : 30.0)));
+
+    int failures = 0;
+    while (true) {
+        bool saturated;
+        bool late;
+        bool wanted;
+        {
+            QMutexLocker locker(&m_mutex);
+            // 文件源缓冲满或已读完时休眠；实时源始终采集
+            while (!m_stopRequested && !m_rewindRequested && !m_seekRequested
+                   && (m_state == State::EndOfStream
+                       || (!m_live && static_cast<int>(m_ring.size()) >= m_capacity))) {
+                m_wakeup.wait(&m_mutex);
+            }
+            if (m_stopRequested) {
+                break;
+            }
+            if (m_rewindRequested) {
+                m_rewindRequested = false;
+                m_ring.clear();
+                m_lastTimestamp = -1;
+                locker.unlock();
+                m_source->rewind();
+                locker.relock();
+                m_state = State::Running;
+                continue;
+            }
+            if (m_seekRequested) {
+                m_seekRequested = false;
+                const qint64 target = m_seekTarget;
+                const bool keyframeOnly = m_seekKeyframeOnly;
+                m_ring.clear();
+                m_lastTimestamp = -1;
+                locker.unlock();
+                if (!m_source->seek(target, keyframeOnly)) {
+                    qWarning() << "无法定位:" << m_description << target << "ms";
+                }
+                locker.relock();
+                m_state = State::Running;
+                continue;
+            }
+            // 在锁内查询信用池，requestStop() 返回后不会再访问它
+            saturated = m_skipWhenSaturated && m_creditPool && !m_creditPool->hasCredit();
+            // 缓冲已空且下一帧在播放位置一帧之前：解码跟不上实时，直接丢弃
+            late = !m_live && m_ring.empty() && m_discardBefore >= 0 && m_lastTimestamp >= 0
+                   && m_lastTimestamp + frameDurationMs < m_discardBefore;
+            // 实时源只为已请求的帧输出像素
+            wanted = m_frameRequested && !saturated;
+        }
+
+        // 在锁外解码，控制调用和取帧不会被阻塞
+        PrefetchedFrame frame;
+        bool ok;
+        if (m_live) {
+            // 实时源持续grab()，驱动中不积压旧帧；只有请求过的帧才retrieve()
+            ok = m_source->grab(frame.timestampMs);
+            frame.captureTimeUs = SharedFrame::monotonicUs();
+            frame.decoded = ok && wanted;
+            if (frame.decoded) {
+                ok = m_source->retrieve(frame.image);
+            }
+        } else {
+            // 处理端饱和或落后于播放位置时只grab()推进时间线，省去retrieve()的解码输出与颜色转换
+            frame.decoded = !late && !saturated;
+            ok = frame.decoded ? m_source->read(frame.image, frame.timestampMs)
+                               : m_source->grab(frame.timestampMs);
+        }
+        frame.format = m_source->pixelFormat();
+
+        QMutexLocker locker(&m_mutex);
+        if (m_stopRequested) {
+            break;
+        }
+        if (m_rewindRequested || m_seekRequested) {
+            continue;   // 解码结果属于回绕或定位前的位置，丢弃
+        }
+
+        if (!ok) {
+            if (m_live) {
+                // 摄像头读取失败，可能是暂时的问题，稍后重试
+                if (++failures % 100 == 1) {
+                    qWarning() << "Failed to read frame from" << m_description;
+                }
+                locker.unlock();
+                QThread::msleep(10);
+                continue;
+            }
+            m_state = State::EndOfStream;
+            notifyLocked();
+            continue;
+        }
+        failures = 0;
+        m_lastTimestamp = frame.timestampMs;
+
+        if (late) {
+            ++m_lateGrabbed;   // 不进入缓冲
+            continue;
+        }
+
+        if (m_live) {
+            if (!frame.decoded) {
+                continue;   // 没有请求：只推进驱动队列
+            }
+            // 新帧覆盖邮箱中未取走的旧帧
+            m_frameRequested = false;
+            m_ring.clear();
+        }
+        const bool wasEmpty = m_ring.empty();
+        m_ring.push_back(std::move(frame));
+        if (wasEmpty) {
+            notifyLocked();
+        }
+    }
+
+    m_source->close();
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThread>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <opencv2/opencv.hpp>
+#include "framesource.h"
+
+class FrameCreditPool;
+
+/**
+ * @brief 预取环中的一帧
+ */
+struct PrefetchedFrame {
+    cv::Mat image;              ///< 解码结果，decoded为false时为空
+    SharedFrame::PixelFormat format = SharedFrame::PixelFormat::BGR;   ///< image 的像素格式
+    qint64 timestampMs = 0;     ///< 帧时间戳(毫秒)
+    qint64 captureTimeUs = -1;  ///< 实时源 grab() 返回的时刻（SharedFrame::monotonicUs()），其它为-1
+    bool decoded = true;        ///< 处理端饱和时只grab()跳过，不输出像素
+};
+
+/**
+ * @class FramePrefetcher
+ * @brief 独立解码线程，在播放位置之前预先解码若干帧
+ *
+ * 解码线程持有 FrameSource，把结果放入容量为 N 的环形缓冲；Reader 的定时器
+ * 只从缓冲中取帧，解码耗时的抖动被缓冲吸收，控制调用也不再等待解码。
+ * 文件源缓冲满时解码线程休眠。
+ *
+ * 实时源的缓冲是单帧邮箱（“最新帧优先”）：采集循环持续 grab() 排空驱动队列，
+ * 只有消费端 requestFrame() 之后才 retrieve() 下一帧放入邮箱并覆盖未取走的旧帧，
+ * 帧不会在驱动或缓冲中排队，显示的总是最新采集到的画面。
+ * 打开输入源同样在解码线程中完成。
+ */
+class FramePrefetcher {
+public:
+    enum class State {
+        Opening,        ///< 正在打开输入源
+        Running,        ///< 正常解码
+        EndOfStream,    ///< 文件已读完，等待回绕
+        Failed          ///< 无法打开输入源
+    };
+
+    /**
+     * @param source 输入源，所有权转移给预取器
+     * @param capacity 预取帧数（实时源固定为1）
+     * @param creditPool 处理端信用池，饱和时跳过解码；可为nullptr
+     */
+    FramePrefetcher(std::unique_ptr<FrameSource> source, int capacity,
+                    FrameCreditPool *creditPool = nullptr);
+    ~FramePrefetcher();
+
+    FramePrefetcher(const FramePrefetcher&) = delete;
+    FramePrefetcher& operator=(const FramePrefetcher&) = delete;
+
+    /**
+     * @brief 启动解码线程
+     */
+    void start();
+
+    /**
+     * @brief 请求解码线程退出，不等待（析构时等待）
+     */
+    void requestStop();
+
+    /**
+     * @brief 非阻塞地取出最早的一帧
+     */
+    bool tryPop(PrefetchedFrame& frame);
+
+    /**
+     * @brief 实时源：请求一帧，采集循环在下一次 grab() 后 retrieve() 放入邮箱
+     *
+     * 请求一直保留到处理端有空位；重复请求等同于一次。
+     */
+    void requestFrame();
+
+    /**
+     * @brief 查看最早一帧的时间戳，不取出
+     */
+    bool peekTimestamp(qint64& timestampMs) const;
+
+    /**
+     * @brief 请求回到开头并清空缓冲（异步执行）
+     */
+    void rewind();
+
+    /**
+     * @brief 请求定位并清空缓冲（异步执行，连续请求只执行最后一次）
+     * @param keyframeOnly 只定位到目标之前的关键帧（拖动预览）
+     */
+    void seek(qint64 timestampMs, bool keyframeOnly);
+
+    State state() const;
+    int buffered() const;
+
+    /**
+     * @brief 输入源标称帧率，打开前或未知时为0
+     */
+    double nominalFps() const;
+
+    /**
+     * @brief 输入源时长(毫秒)，打开前或未知时为-1
+     */
+    qint64 durationMs() const;
+
+    /**
+     * @brief 告知当前播放位置；文件源解码落后于该位置超过一帧时只grab()丢弃，直到追上
+     * @param mediaMs 播放时钟对应的媒体时间(毫秒)，<0 表示不丢弃
+     */
+    void setDiscardBefore(qint64 mediaMs);
+
+    /**
+     * @brief 为追赶播放位置而grab()丢弃的帧数
+     */
+    quint64 lateGrabbed() const;
+    bool isLive() const { return m_live; }
+    QString description() const { return m_description; }
+
+    /**
+     * @brief 处理端饱和时是否跳过解码（最大吞吐模式下应关闭，保证不跳帧）
+     */
+    void setSkipWhenSaturated(bool skip);
+
+    /**
+     * @brief 缓冲由空变为非空或状态变化时在解码线程中调用；回调内不得阻塞
+     */
+    void setNotifyCallback(std::function<void()> callback);
+
+private:
+    void run();
+    void notifyLocked();
+
+    std::unique_ptr<FrameSource> m_source;  // 只在解码线程中访问
+    FrameCreditPool *m_creditPool;
+    const int m_capacity;
+    const bool m_live;
+    const QString m_description;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_wakeup;                // 有空位、回绕或退出时唤醒解码线程
+    std::deque<PrefetchedFrame> m_ring;
+    std::function<void()> m_notify;
+    State m_state = State::Opening;
+    bool m_stopRequested = false;
+    bool m_rewindRequested = false;
+    bool m_seekRequested = false;
+    bool m_seekKeyframeOnly = false;
+    qint64 m_seekTarget = 0;
+    bool m_skipWhenSaturated = true;
+    bool m_frameRequested = true;           // 实时源：消费端等待下一帧
+    double m_fps = 0.0;
+    qint64 m_durationMs = -1;
+    qint64 m_discardBefore = -1;            // 播放位置，早于它一帧以上的帧不再解码
+    qint64 m_lastTimestamp = -1;            // 最近一次读取或跳过的帧时间戳
+    quint64 m_lateGrabbed = 0;
+    QThread *m_thread = nullptr;
+};
@@ -1,15 +1,27 @@
 #include "frameprocessor.h"
 #include "CommonUtils.h"
+#include "taskscheduler.h"
+#include "sharedprefixcache.h"
 #include <QDebug>
+#include <QSettings>
+
+namespace {
+// 自动模式下的并行帧数上限：帧越多延迟越大，超过4帧收益已不明显
+const int kAutoMaxFramesInFlight = 4;
+}
 
 FrameProcessor::FrameProcessor(QObject *parent)
-    : QObject(parent), m_running(false), m_algorithmModel(new AlgorithmListModel(this))
+    : QObject(parent), m_frameQueue(5, FrameDropPolicy::DropOldest)
+    , m_running(false), m_maxFramesInFlight(0)
+    , m_executionMode(ExecutionMode::FrameParallel), m_pipelineStages(0), m_workingHeight(0)
+    , m_algorithmModel(new AlgorithmListModel(this))
 {
-    // 将处理器移到专用线程
-    moveToThread(&m_thread);
-    
-    // 连接线程启动信号到处理槽
-    connect(&m_thread, &QThread::started, this, &FrameProcessor::processFrames);
+    // 处理器与算法模型留在创建线程（GUI线程），帧处理在共享线程池中执行
+    QSettings settings("QOMIPPlatform", "Scheduler");
+    m_maxFramesInFlight = qMax(0, settings.value("max_frames_in_flight", 0).toInt());
+    m_backgroundStride = qMax(1, settings.value("background_stride", 5).toInt());
+    m_catchUpCapacity = qMax(0, settings.value("catch_up_frames", 8).toInt());
+    m_workingHeight = qMax(0, settings.value("working_height", 0).toInt());
 }
 
 FrameProcessor::~FrameProcessor()
@@ -43,138 +55,601 @@ bool FrameProcessor::updateAlgorithmParams(int index, const QVariantMap &params)
     return false;
 }
 
-void FrameProcessor::enqueueFrame(const cv::Mat& frame)
+void FrameProcessor::enqueueFrame(const SharedFrame& frame)
 {
-    if (!m_running) return;
+    if (!m_running.load() || frame.empty()) return;
+    
+    // 后台或暂停的视图按优先级跳过部分帧
+    if (!admitFrame(frame)) return;
     
+    // 队列满时按丢帧策略处理，Block策略下会阻塞调用方直到有空位
+    if (m_frameQueue.push(frame)) {
+        scheduleProcessing();
+    }
+    publishCredits();
+}
+
+void FrameProcessor::setQueueCapacity(int capacity)
+{
+    m_frameQueue.setCapacity(capacity);
+}
+
+int FrameProcessor::queueCapacity() const
+{
+    return m_frameQueue.capacity();
+}
+
+void FrameProcessor::setDropPolicy(FrameDropPolicy policy)
+{
+    m_frameQueue.setDropPolicy(policy);
+}
+
+FrameDropPolicy FrameProcessor::dropPolicy() const
+{
+    return m_frameQueue.dropPolicy();
+}
+
+FrameChannelStats FrameProcessor::frameStats() const
+{
+    return m_frameQueue.stats();
+}
+
+void FrameProcessor::resetFrameStats()
+{
+    m_frameQueue.resetStats();
+}
+
+void FrameProcessor::setMaxFramesInFlight(int count)
+{
+    m_maxFramesInFlight = qMax(0, count);
     
+    // 上限提高时立即补充任务
+    scheduleProcessing();
+}
+
+int FrameProcessor::maxFramesInFlight() const
+{
+    return m_maxFramesInFlight.load();
+}
+
+void FrameProcessor::setExecutionMode(ExecutionMode mode)
+{
+    m_executionMode = mode;
+    scheduleProcessing();
+}
+
+ExecutionMode FrameProcessor::executionMode() const
+{
+    return m_executionMode.load();
+}
+
+void FrameProcessor::setPipelineStages(int count)
+{
+    m_pipelineStages = qMax(0, count);
+    scheduleProcessing();
+}
+
+int FrameProcessor::pipelineStages() const
+{
+    return m_pipelineStages.load();
+}
+
+void FrameProcessor::setWorkingResolution(int rows)
+{
+    // 各副本在处理下一帧前读取，不需要等待在途帧
+    m_workingHeight = qMax(0, rows);
+}
+
+int FrameProcessor::workingResolution() const
+{
+    return m_workingHeight.load();
+}
+
+bool FrameProcessor::admitFrame(const SharedFrame& frame)
+{
+    QMutexLocker locker(&m_mutex);
+    bool accept = true;
+    if (m_priority == ViewPriority::Background) {
+        accept = (m_throttleCounter++ % m_backgroundStride) == 0;
+    } else if (m_priority == ViewPriority::Paused) {
+        accept = false;
+    }
     
-    // 如果队列太长，可能丢弃旧帧以避免内存问题
-    if (m_frameQueue.size() > 5) {
-        m_frameQueue.dequeue();
+    if (accept) {
+        // 缓冲中的帧都早于这一帧，状态已无法按顺序补上
+        m_catchUp.clear();
+        return true;
     }
     
-    m_frameQueue.enqueue(frame.clone());
-    m_condition.wakeOne();
+    // 只有有状态链需要补处理，无状态链恢复前台后直接处理新帧即可
+    refreshSnapshot();
+    if (m_catchUpCapacity > 0 && m_snapshot->hasStatefulStage()) {
+        m_catchUp.push_back(frame);
+        while (static_cast<int>(m_catchUp.size()) > m_catchUpCapacity) {
+            m_catchUp.pop_front();
+        }
+    }
+    return false;
 }
 
-void FrameProcessor::startProcessing()
+void FrameProcessor::setPriority(ViewPriority priority)
 {
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_priority == priority) {
+            return;
+        }
+        const bool promoted = priority == ViewPriority::Foreground;
+        m_priority = priority;
+        m_throttleCounter = 0;
+        
+        if (promoted && !m_catchUp.empty()) {
+            // 已排队的帧早于缓冲中的帧，先按原顺序移入重放队列，再追加补处理帧
+            SharedFrame queued;
+            while (m_frameQueue.tryPop(queued)) {
+                m_replay.push_back({queued, false});
+            }
+            for (const SharedFrame& frame : m_catchUp) {
+                m_replay.push_back({frame, true});
+            }
+            m_catchUp.clear();
+        } else if (!promoted) {
+            // 降级后缓冲从降级时刻重新开始
+            m_catchUp.clear();
+        }
+    }
     
+    scheduleProcessing();
+    publishCredits();
+}
+
+ViewPriority FrameProcessor::priority() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_priority;
+}
+
+void FrameProcessor::setBackgroundStride(int stride)
+{
+    QMutexLocker locker(&m_mutex);
+    m_backgroundStride = qMax(1, stride);
+}
+
+int FrameProcessor::backgroundStride() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_backgroundStride;
+}
+
+void FrameProcessor::setCatchUpCapacity(int frames)
+{
+    QMutexLocker locker(&m_mutex);
+    m_catchUpCapacity = qMax(0, frames);
+    while (static_cast<int>(m_catchUp.size()) > m_catchUpCapacity) {
+        m_catchUp.pop_front();
+    }
+}
+
+int FrameProcessor::catchUpCapacity() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_catchUpCapacity;
+}
+
+int FrameProcessor::availableCredits() const
+{
+    QMutexLocker locker(&m_mutex);
+    return creditsLocked();
+}
+
+int FrameProcessor::creditsLocked() const
+{
+    // 暂停的视图不需要新帧，不应促使读取端解码
+    if (!m_running.load() || m_priority == ViewPriority::Paused) {
+        return 0;
+    }
+    const int held = m_frameQueue.size() + static_cast<int>(m_replay.size()) + m_inFlight;
+    return qMax(0, m_creditWindow - held);
+}
+
+bool FrameProcessor::takeNextFrame(SharedFrame& frame, bool& silent)
+{
+    // 重放队列中的帧都早于通道中的帧
+    if (!m_replay.empty()) {
+        frame = std::move(m_replay.front().frame);
+        silent = m_replay.front().silent;
+        m_replay.pop_front();
+        return true;
+    }
+    silent = false;
+    return m_frameQueue.tryPop(frame);
+}
+
+void FrameProcessor::clearPendingFrames()
+{
+    QMutexLocker locker(&m_mutex);
+    m_replay.clear();
+    m_catchUp.clear();
+}
+
+void FrameProcessor::publishCredits()
+{
+    // 在锁内发出，保证各线程发出的信用值顺序与实际变化一致
+    QMutexLocker locker(&m_mutex);
+    emit creditsChanged(creditsLocked());
+}
+
+void FrameProcessor::startProcessing()
+{
+    m_frameQueue.open();
     m_running = true;
     
-    // 如果线程未运行，启动它
-    if (!m_thread.isRunning()) {
-        // 确保信号连接正确
-        disconnect(&m_thread, &QThread::started, this, &FrameProcessor::processFrames);
-        connect(&m_thread, &QThread::started, this, &FrameProcessor::processFrames);
-        m_thread.start();
-    } else {
-        // 线程已运行，唤醒它继续处理
-        m_condition.wakeAll();
-    }
+    // 恢复处理时队列或重放队列中可能还有帧
+    scheduleProcessing();
+    publishCredits();
 }
 
 void FrameProcessor::stopProcessing()
 {
-  
     m_running = false;
-    m_condition.wakeAll();  // 唤醒线程，让它检查m_running标志
     
-    // 清空队列
+    // 清空队列，排队中的处理任务会直接返回
     m_frameQueue.clear();
+    clearPendingFrames();
+    publishCredits();
 }
 
 void FrameProcessor::terminateProcessing()
 {
+    m_running = false;
+    
+    // 关闭通道，拒绝新帧并唤醒阻塞的生产者
+    m_frameQueue.close();
+    m_frameQueue.clear();
+    clearPendingFrames();
+    publishCredits();
+    
+    // 等待已提交的处理任务结束（任务持有this指针）
+    QMutexLocker locker(&m_mutex);
+    while (m_activeTasks > 0) {
+        if (!m_idle.wait(&m_mutex, 3000)) {
+            qWarning() << "FrameProcessor 处理任务无法在3秒内结束，继续等待";
+        }
+    }
+}
+
+void FrameProcessor::refreshSnapshot()
+{
+    // 模型有修改时才重新生成快照，其余帧只比较一次修订号
+    if (!m_snapshot || m_snapshot->revision != m_algorithmModel->revision()) {
+        m_snapshot = std::make_shared<const AlgorithmChainSnapshot>(m_algorithmModel->snapshot());
+    }
+}
+
+int FrameProcessor::frameLimit() const
+{
+    // 有状态算法依赖上一帧的结果，只能串行
+    if (m_snapshot->hasStatefulStage()) {
+        return 1;
+    }
+    
+    const int configured = m_maxFramesInFlight.load();
+    if (configured > 0) {
+        return configured;
+    }
+    return qBound(1, TaskScheduler::instance().workerCount(), kAutoMaxFramesInFlight);
+}
+
+AlgorithmChain* FrameProcessor::acquireChain()
+{
+    if (m_idleChains.empty()) {
+        // 新副本在第一次处理时按快照创建算法实例；同一视图的副本共用一个前缀共享标识
+        m_chains.push_back(std::make_unique<AlgorithmChain>());
+        m_chains.back()->enablePrefixSharing(&SharedPrefixCache::instance(), this);
+        return m_chains.back().get();
+    }
+    
+    AlgorithmChain* chain = m_idleChains.back();
+    m_idleChains.pop_back();
+    return chain;
+}
+
+bool FrameProcessor::isDrained() const
+{
+    return m_inFlight == 0 && m_stageTasks == 0;
+}
+
+void FrameProcessor::scheduleProcessing()
+{
+    if (!m_running.load()) {
+        return;
+    }
+    
+    std::vector<FrameJob> jobs;
+    bool pipelineAdmitted = false;
     {
         QMutexLocker locker(&m_mutex);
-        m_running = false;
-        m_frameQueue.clear();
-        m_condition.wakeAll();
+        refreshSnapshot();
+        
+        // 切换执行方式要等在途帧全部完成，两种方式不共享算法实例
+        const ExecutionMode requested = m_executionMode.load();
+        if (requested != m_activeMode) {
+            if (!isDrained()) {
+                return;
+            }
+            m_activeMode = requested;
+            if (m_activeMode == ExecutionMode::StagePipelined) {
+                m_chains.clear();
+                m_idleChains.clear();
+            } else {
+                m_stages.clear();
+                m_pipelineStageSetting = -1;
+            }
+        }
+        
+        if (m_activeMode == ExecutionMode::StagePipelined) {
+            pipelineAdmitted = dispatchPipeline();
+        } else {
+            dispatchFrameParallel(jobs);
+        }
+    }
+    
+    // 在锁外提交：线程池未运行时任务会在本线程同步执行
+    if (pipelineAdmitted) {
+        scheduleStage(0);
+    }
+    for (FrameJob& job : jobs) {
+        TaskScheduler::instance().submit([this, job = std::move(job)]() { processFrame(job); });
+    }
+}
+
+void FrameProcessor::dispatchFrameParallel(std::vector<FrameJob>& jobs)
+{
+    const int limit = frameLimit();
+    m_creditWindow = limit + 1;
+    if (limit == 1 && m_inFlight == 0 && m_chains.size() > 1) {
+        // 进入串行模式：只保留一个副本，有状态算法的状态始终在同一实例上累积
+        m_chains.resize(1);
+        m_idleChains.assign(1, m_chains.front().get());
+    }
+    
+    while (m_inFlight < limit) {
+        SharedFrame frame;
+        bool silent = false;
+        if (!takeNextFrame(frame, silent)) {
+            break;
+        }
+        
+        FrameJob job;
+        job.ticket = m_reorder.nextTicket();
+        job.frame = std::move(frame);
+        job.silent = silent;
+        job.chain = acquireChain();
+        job.snapshot = m_snapshot;
+        jobs.push_back(std::move(job));
+        
+        ++m_inFlight;
+        ++m_activeTasks;
+    }
+}
+
+void FrameProcessor::processFrame(const FrameJob& job)
+{
+    SharedFrame output;
+    
+    try {
+        // 副本落后于分发时的快照才同步，已有实例和参数会被复用
+        job.chain->setWorkingHeight(m_workingHeight.load());
+        if (job.chain->revision() != job.snapshot->revision) {
+            job.chain->sync(*job.snapshot);
+        }
+        
+        // 算法链直接读取共享帧像素，只有产生新像素的阶段才会分配内存
+        const cv::Mat result = job.chain->process(job.frame);
+        
+        // 补处理帧只推进算法状态，以空帧占位不发出
+        if (!job.silent) {
+            output = job.frame.derive(result);
+        }
+    }
+    catch (const cv::Exception& e) {
+        qWarning() << "OpenCV错误:" << e.what();
+    }
+    catch (const std::exception& e) {
+        qWarning() << "标准异常:" << e.what();
+    }
+    
+    if (!job.silent) {
+        m_frameQueue.markProcessed();
     }
     
-    // 请求线程中断
-    m_thread.requestInterruption();
+    // 失败的帧以空帧占位，避免阻塞后续帧
+    m_mutex.lock();
+    m_reorder.insert(job.ticket, output);
+    m_idleChains.push_back(job.chain);
+    --m_inFlight;
+    emit creditsChanged(creditsLocked());
+    const std::vector<SharedFrame> ready = m_reorder.takeReady();
     
-    // 退出事件循环并等待线程结束
-    if (m_thread.isRunning()) {
-        m_thread.quit();
-        if (!m_thread.wait(3000)) {
-            qWarning() << "FrameProcessor 线程无法在3秒内终止，强制终止";
-            m_thread.terminate();
-            m_thread.wait(); // 即使在terminate后也需要wait
+    // 先取得发送锁再释放m_mutex，后取出的结果不会抢在前面发出
+    m_emitMutex.lock();
+    m_mutex.unlock();
+    for (const SharedFrame& frame : ready) {
+        if (!frame.isNull()) {
+            // 发送处理结果：接收方直接连接，在处理线程中执行，只能放入邮箱或排队，不能阻塞
+            emit frameProcessed(frame);
         }
     }
+    m_emitMutex.unlock();
     
-    // 不需要再次调用quit()
+    // 空出了一个并行位置，继续分发排队的帧
+    scheduleProcessing();
+    
+    // 最后才减少任务计数，此后不能再访问this
+    QMutexLocker locker(&m_mutex);
+    if (--m_activeTasks == 0) {
+        m_idle.wakeAll();
+    }
 }
 
-void FrameProcessor::processFrames()
+bool FrameProcessor::dispatchPipeline()
 {
-    while (!m_thread.isInterruptionRequested()) {
-        cv::Mat frame;
-        //QVector<QPair<int, QVariantMap>> algorithms;
+    // 算法链或阶段划分变化：暂停进帧，等在途帧流出流水线后再重建
+    const int setting = m_pipelineStages.load();
+    if (m_stages.empty() || m_pipelineRevision != m_snapshot->revision
+        || m_pipelineStageSetting != setting) {
+        if (!isDrained()) {
+            return false;
+        }
+        rebuildPipeline();
+    }
+    
+    // 每个阶段各处理一帧，再多预留一帧让第一阶段空闲时立即有帧可取
+    const int limit = static_cast<int>(m_stages.size()) + 1;
+    m_creditWindow = limit + 1;
+    bool admitted = false;
+    while (m_inFlight < limit) {
+        SharedFrame frame;
+        bool silent = false;
+        if (!takeNextFrame(frame, silent)) {
+            break;
+        }
         
-        {
-            // 如果没有运行或队列为空，则等待
-            while (!m_running || m_frameQueue.isEmpty()) {
-                // 如果线程被请求中断，则退出
-                if (m_thread.isInterruptionRequested()) {
-                    return;
+        PipelineItem item;
+        item.silent = silent;
+        item.frame = std::move(frame);
+        m_stages.front()->input.push(std::move(item));
+        
+        ++m_inFlight;
+        admitted = true;
+    }
+    return admitted;
+}
+
+void FrameProcessor::rebuildPipeline()
+{
+    const int total = m_snapshot->entries.size();
+    const int setting = m_pipelineStages.load();
+    const int count = qMax(1, setting > 0 ? qMin(setting, total) : total);
+    const int capacity = count + 1;
+    
+    // 复用已有阶段对象：条目仍落在同一阶段时，其算法实例和状态得以保留
+    m_stages.resize(qMin<size_t>(m_stages.size(), count));
+    while (static_cast<int>(m_stages.size()) < count) {
+        m_stages.push_back(std::make_unique<PipelineStage>(capacity));
+    }
+    
+    // 相邻算法尽量均分到各阶段
+    for (int i = 0; i < count; ++i) {
+        const int begin = i * total / count;
+        const int end = (i + 1) * total / count;
+        PipelineStage& stage = *m_stages[i];
+        stage.slice.revision = m_snapshot->revision;
+        stage.slice.entries = m_snapshot->entries.mid(begin, end - begin);
+        stage.input.setCapacity(capacity);
+    }
+    
+    // 只有第一阶段从链首开始，其签名才能与其它视图的前缀匹配
+    m_stages.front()->chain.enablePrefixSharing(&SharedPrefixCache::instance(), this);
+    
+    m_pipelineRevision = m_snapshot->revision;
+    m_pipelineStageSetting = setting;
+}
+
+void FrameProcessor::scheduleStage(int index)
+{
+    // 只在有帧在途时调用，此期间流水线不会被重建
+    PipelineStage& stage = *m_stages[index];
+    if (stage.scheduled.exchange(true)) {
+        return;
+    }
+    
+    {
+        QMutexLocker locker(&m_mutex);
+        ++m_activeTasks;
+        ++m_stageTasks;
+    }
+    
+    TaskScheduler::instance().submit([this, index]() { runStage(index); });
+}
+
+void FrameProcessor::runStage(int index)
+{
+    PipelineStage& stage = *m_stages[index];
+    const bool lastStage = index + 1 == static_cast<int>(m_stages.size());
+    bool finished = false;
+    
+    // 每个任务只处理一帧，让其它阶段和视图在线程池中公平轮转
+    PipelineItem item;
+    if (stage.input.tryPop(item)) {
+        if (!item.failed) {
+            try {
+                // 只有第一阶段缩小输入，后续阶段沿用工作分辨率和全分辨率上下文
+                if (index == 0) {
+                    stage.chain.setWorkingHeight(m_workingHeight.load());
                 }
-                
-                // // 使用超时等待，以便定期检查中断状态
-                // if (!m_condition.wait(&m_mutex, 500)) {
-                //     // 超时后再次检查中断请求
-                //     if (m_thread.isInterruptionRequested()) {
-                //         return;  // 立即返回，结束线程
-                //     }
-                //     continue;
-                // }
-                if (m_thread.isInterruptionRequested()) {
-                    return;  // 立即返回，结束线程
+                if (stage.chain.revision() != stage.slice.revision) {
+                    stage.chain.sync(stage.slice);
                 }
-                
-                // 再次检查运行状态
-                if (!m_running && m_frameQueue.isEmpty()) {
-                    continue;  // 如果停止运行且没有帧，则继续等待
+                // 第一阶段的输入就是原始帧，可以取用其它视图的公共前缀结果
+                if (index == 0) {
+                    item.image = stage.chain.processWorking(item.frame);
+                } else {
+                    stage.chain.processWorking(item.image);
                 }
             }
-            
-            // 取出队首帧
-            frame = m_frameQueue.dequeue();
+            catch (const cv::Exception& e) {
+                qWarning() << "OpenCV错误:" << e.what();
+                item.failed = true;
+            }
+            catch (const std::exception& e) {
+                qWarning() << "标准异常:" << e.what();
+                item.failed = true;
+            }
         }
         
-        // 获取当前算法的克隆列表
-        QVector<Algorithm*> algorithms = m_algorithmModel->getAllAlgorithms();
-        
-        try {
-            // 获取当前算法列表
-            QVector<Algorithm*> algorithms = m_algorithmModel->getAllAlgorithms();
-            
-            // 初始结果为输入帧
-            cv::Mat result = frame.clone();
-            
-            // 依次应用每个算法
-            for (Algorithm* algorithm : algorithms) {
-                if (algorithm) {
-                    result = algorithm->process(result);
+        if (!lastStage) {
+            m_stages[index + 1]->input.push(std::move(item));
+            scheduleStage(index + 1);
+        } else {
+            // 各阶段串行且先进先出，帧到达末级的顺序就是输入顺序
+            if (!item.silent) {
+                if (!item.failed) {
+                    emit frameProcessed(item.frame.derive(item.image.output()));
                 }
+                m_frameQueue.markProcessed();
             }
-            
-            // 发送处理结果
-            emit frameProcessed(result);
-            
-            // 清理克隆的算法实例
-            qDeleteAll(algorithms);
-        }
-        catch (const cv::Exception& e) {
-            qWarning() << "OpenCV错误:" << e.what();
+            finished = true;
         }
-        catch (const std::exception& e) {
-            qWarning() << "标准异常:" << e.what();
+    }
+    
+    // 先清除标志再检查队列，避免与上一阶段竞争导致漏处理
+    stage.scheduled = false;
+    if (!stage.input.isEmpty()) {
+        scheduleStage(index);
+    }
+    
+    bool admit = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        --m_stageTasks;
+        if (finished) {
+            --m_inFlight;
+            emit creditsChanged(creditsLocked());
         }
+        // 有帧流出或流水线已排空（可能在等待重建）时继续进帧
+        admit = finished || isDrained();
+    }
+    
+    // 此后流水线可能被重建，不能再访问stage
+    if (admit) {
+        scheduleProcessing();
+    }
+    
+    // 最后才减少任务计数，此后不能再访问this
+    QMutexLocker locker(&m_mutex);
+    if (--m_activeTasks == 0) {
+        m_idle.wakeAll();
     }
 }
 
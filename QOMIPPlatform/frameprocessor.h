@@ -1,20 +1,51 @@
 #pragma once
 
 #include <QObject>
-#include <QQueue>
 #include <QMutex>
-#include <QThread>
 #include <QWaitCondition>
 #include <QVector>
 #include <QPair>
 #include <QString>
 #include <QVariantMap>
 #include <opencv2/opencv.hpp>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
 #include "algorithmlistmodel.h"
+#include "framechannel.h"
+#include "algorithmchain.h"
+#include "sharedframe.h"
+#include "reorderbuffer.h"
 #include "Algorithms/algorithm.h" // 添加这行确保Algorithm类可用
+
+/**
+ * @brief 算法链的执行方式
+ */
+enum class ExecutionMode {
+    FrameParallel,  ///< 整条链作为一个任务；无状态链多帧并行，有状态链单帧串行（默认）
+    StagePipelined  ///< 链按阶段拆分，每个阶段串行执行，不同阶段同时处理不同的帧
+};
+
+/**
+ * @brief 视图的调度优先级
+ */
+enum class ViewPriority {
+    Foreground,     ///< 可见或获得焦点的视图，处理每一帧
+    Background,     ///< 隐藏的视图，每 backgroundStride 帧处理一帧
+    Paused          ///< 隐藏的视图，不处理新帧
+};
+
 /**
  * @class FrameProcessor
  * @brief 视频帧处理器，支持多算法处理队列
+ *
+ * 不再独占线程：帧处理以任务形式提交到共享的 TaskScheduler。
+ * 链中全部为无状态算法时，最多 maxFramesInFlight 帧在各自的算法链副本上并行处理，
+ * 结果经重排缓冲区按输入顺序发出；含有状态算法（背景建模、帧差、光流等）时
+ * 自动退化为单帧串行，保证状态按帧顺序演进。
+ * 流水线模式下链被拆成若干串行阶段，吞吐量取决于最慢的阶段而不是各阶段之和，
+ * 有状态算法同样适用。
  */
 class FrameProcessor : public QObject {
     Q_OBJECT
@@ -46,32 +77,169 @@ public:
     QString getAlgorithmName(int index) const;
     QVariantMap getAlgorithmParams(int index) const;
     
-    // 将帧添加到处理队列
-    void enqueueFrame(const cv::Mat& frame);
+    // 将帧添加到处理队列（只增加引用计数，不拷贝像素）
+    void enqueueFrame(const SharedFrame& frame);
+    
+    // 队列容量与丢帧策略
+    void setQueueCapacity(int capacity);
+    int queueCapacity() const;
+    void setDropPolicy(FrameDropPolicy policy);
+    FrameDropPolicy dropPolicy() const;
+    
+    // 获取入队/丢弃/已处理帧计数
+    FrameChannelStats frameStats() const;
+    void resetFrameStats();
+    
+    // 无状态链同时处理的最大帧数，0表示自动（取决于线程池大小）
+    void setMaxFramesInFlight(int count);
+    int maxFramesInFlight() const;
+    
+    // 执行方式，切换在当前帧处理完后生效
+    void setExecutionMode(ExecutionMode mode);
+    ExecutionMode executionMode() const;
+    
+    // 流水线阶段数，0表示每个算法一个阶段；阶段数少于算法数时相邻算法合并为一组
+    void setPipelineStages(int count);
+    int pipelineStages() const;
+    
+    // 工作分辨率（帧高度）：帧进入算法链时缩小一次，检测结果画回全分辨率；0表示原始分辨率
+    void setWorkingResolution(int rows);
+    int workingResolution() const;
+    
+    // 还能接收而不会丢帧的帧数（信用），未运行或暂停时为0
+    int availableCredits() const;
+    
+    /**
+     * @brief 设置调度优先级
+     *
+     * 非前台期间跳过的帧在链含有状态算法时会保留最近若干帧，
+     * 恢复为前台时先不发出结果地补处理这些帧，让背景模型等状态追上当前画面。
+     */
+    void setPriority(ViewPriority priority);
+    ViewPriority priority() const;
+    
+    // 后台视图的处理间隔（每N帧处理一帧）
+    void setBackgroundStride(int stride);
+    int backgroundStride() const;
+    
+    // 补处理缓冲的最大帧数，0表示不补处理
+    void setCatchUpCapacity(int frames);
+    int catchUpCapacity() const;
     
     // 启动/停止处理
     void startProcessing();
     void stopProcessing();
-    // 终止处理线程并清空队列
+    // 终止处理并清空队列，等待正在执行的处理任务结束
     void terminateProcessing();
 
 signals:
-    // 处理完成后发出信号
-    void frameProcessed(const cv::Mat& result);
+    // 处理完成后在处理线程中发出，结果继承输入帧的序号和时间戳；接收方直接连接时只能放入邮箱或排队
+    void frameProcessed(const SharedFrame& result);
     
     // 处理错误
     void processingError(const QString& errorMessage);
-
-private slots:
-    // 处理队列中的帧
-    void processFrames();
+    
+    // 信用变化（在发生变化的线程中直接发出，供 FrameCreditPool 使用）
+    void creditsChanged(int credits);
 
 private:
-    QThread m_thread;                    // 处理线程
-    QQueue<cv::Mat> m_frameQueue;        // 帧队列
+    // 一帧处理任务所需的全部数据
+    struct FrameJob {
+        quint64 ticket = 0;                                     // 重排票号
+        SharedFrame frame;                                      // 输入帧
+        AlgorithmChain* chain = nullptr;                        // 本帧独占的算法链副本
+        std::shared_ptr<const AlgorithmChainSnapshot> snapshot; // 分发时的模型快照
+        bool silent = false;                                    // 补处理帧，只更新状态不发出结果
+    };
+    
+    // 恢复前台时待重新分发的帧
+    struct ReplayFrame {
+        SharedFrame frame;
+        bool silent = false;
+    };
+    
+    // 流水线中传递的一帧
+    struct PipelineItem {
+        SharedFrame frame;      // 输入帧（提供序号和时间戳）
+        WorkingImage image;     // 上一阶段的输出（含工作分辨率下的全分辨率上下文）
+        bool failed = false;    // 某个阶段处理失败，后续阶段直接跳过
+        bool silent = false;    // 补处理帧，只更新状态不发出结果
+    };
+    
+    // 流水线的一个阶段：串行执行，阶段内的算法实例只被本阶段访问
+    struct PipelineStage {
+        explicit PipelineStage(int capacity)
+            : input(capacity, FrameDropPolicy::DropNewest) {}
+        
+        AlgorithmChainSnapshot slice;           // 本阶段负责的算法条目
+        AlgorithmChain chain;                   // 本阶段的长期算法实例
+        FrameChannel<PipelineItem> input;       // 等待本阶段处理的帧
+        std::atomic<bool> scheduled{false};     // 是否已有本阶段的任务在排队或执行
+    };
+    
+    // 按当前执行方式从队列取帧并提交处理任务
+    void scheduleProcessing();
+    
+    // 在线程池中处理一帧，并按顺序发出已就绪的结果
+    void processFrame(const FrameJob& job);
+    
+    // 流水线：提交某个阶段的任务 / 阶段任务主体
+    void scheduleStage(int index);
+    void runStage(int index);
+    
+    // 计算并发出当前信用
+    void publishCredits();
+    
+    // 按优先级决定是否处理该帧，跳过的帧按需放入补处理缓冲
+    bool admitFrame(const SharedFrame& frame);
+    
+    // 丢弃重放队列和补处理缓冲
+    void clearPendingFrames();
+    
+    // 以下函数需持有m_mutex
+    int creditsLocked() const;
+    bool takeNextFrame(SharedFrame& frame, bool& silent);
+    void refreshSnapshot();
+    int frameLimit() const;
+    AlgorithmChain* acquireChain();
+    bool isDrained() const;
+    void dispatchFrameParallel(std::vector<FrameJob>& jobs);
+    bool dispatchPipeline();
+    void rebuildPipeline();
+    
+    FrameChannel<SharedFrame> m_frameQueue; // 有界帧通道
     mutable QMutex m_mutex;              // 互斥锁 (mutable使其可在const方法中使用)
-    QWaitCondition m_condition;          // 条件变量
-    bool m_running;                      // 运行标志
+    QMutex m_emitMutex;                  // 保证不同任务取出的结果按顺序发出
+    QWaitCondition m_idle;               // 所有处理任务结束时唤醒
+    std::atomic<bool> m_running;         // 运行标志
+    std::atomic<int> m_maxFramesInFlight; // 并行帧数上限，0为自动
+    std::atomic<ExecutionMode> m_executionMode; // 请求的执行方式
+    std::atomic<int> m_pipelineStages;    // 请求的流水线阶段数，0为每个算法一个阶段
+    std::atomic<int> m_workingHeight;     // 工作分辨率（帧高度），0为原始分辨率
+    int m_activeTasks = 0;               // 已提交但未结束的任务数（受m_mutex保护）
+    int m_inFlight = 0;                  // 正在处理的帧数（受m_mutex保护）
+    int m_stageTasks = 0;                // 未结束的流水线阶段任务数（受m_mutex保护）
+    int m_creditWindow = 2;              // 可同时持有的帧数：并行上限+1个排队（受m_mutex保护）
     
     AlgorithmListModel* m_algorithmModel; // 算法列表模型
+    
+    // 以下成员受m_mutex保护
+    std::shared_ptr<const AlgorithmChainSnapshot> m_snapshot;  // 最近一次的模型快照
+    std::vector<std::unique_ptr<AlgorithmChain>> m_chains;      // 长期算法实例副本
+    std::vector<AlgorithmChain*> m_idleChains;                  // 当前空闲的副本
+    ReorderBuffer<SharedFrame> m_reorder;                       // 按输入顺序恢复结果
+    
+    // 调度优先级（受m_mutex保护）
+    ViewPriority m_priority = ViewPriority::Foreground;
+    int m_backgroundStride = 5;             // 后台视图每N帧处理一帧
+    int m_throttleCounter = 0;              // 后台模式下的帧计数
+    int m_catchUpCapacity = 8;              // 补处理缓冲容量
+    std::deque<SharedFrame> m_catchUp;      // 非前台期间跳过的最近帧（仅有状态链）
+    std::deque<ReplayFrame> m_replay;       // 恢复前台后优先分发的帧
+    
+    // 流水线状态（受m_mutex保护，只在没有帧在途时重建）
+    ExecutionMode m_activeMode = ExecutionMode::FrameParallel;  // 当前生效的执行方式
+    std::vector<std::unique_ptr<PipelineStage>> m_stages;       // 流水线各阶段
+    quint64 m_pipelineRevision = 0;                             // 流水线对应的模型修订号
+    int m_pipelineStageSetting = -1;                            // 构建时使用的阶段数设置
 };
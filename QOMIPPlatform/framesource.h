@@ -0,0 +1,105 @@
+#pragma once
+
+#include <QString>
+#include <QtGlobal>
+#include <opencv2/opencv.hpp>
+#include "sharedframe.h"
+
+/**
+ * @class FrameSource
+ * @brief 帧输入源接口
+ *
+ * 把“从哪里取帧”与“何时发帧”分开：Reader 只负责节奏和分发，
+ * 具体的打开、解码、跳帧、回绕由实现类完成。实现类只会被一个解码线程调用，
+ * 不需要自己加锁。
+ */
+class FrameSource {
+public:
+    virtual ~FrameSource() = default;
+
+    /**
+     * @brief 打开输入源（可能较慢，在解码线程中调用）
+     */
+    virtual bool open() = 0;
+
+    virtual void close() = 0;
+
+    virtual bool isOpened() const = 0;
+
+    /**
+     * @brief 是否为实时源（摄像头等）：不能回绕，来不及处理时应丢弃旧帧
+     */
+    virtual bool isLive() const = 0;
+
+    /**
+     * @brief 解码下一帧
+     * @param frame 输出帧（每次为新分配的缓冲区），格式见 pixelFormat()
+     * @param timestampMs 输出帧时间戳(毫秒)
+     * @return 读取失败或到达结尾时返回false
+     */
+    virtual bool read(cv::Mat& frame, qint64& timestampMs) = 0;
+
+    /**
+     * @brief 最近一次 read()/retrieve() 输出的像素格式；解码器直接交出平面 YUV 时不为 BGR
+     */
+    virtual SharedFrame::PixelFormat pixelFormat() const { return SharedFrame::PixelFormat::BGR; }
+
+    /**
+     * @brief 跳过下一帧，不输出像素
+     * @param timestampMs 输出被跳过帧的时间戳(毫秒)
+     */
+    virtual bool grab(qint64& timestampMs) = 0;
+
+    /**
+     * @brief 请求中止正在阻塞的 read()/grab()，之后两者尽快返回false
+     *
+     * 唯一可以在解码线程之外调用的方法，实现必须线程安全。
+     */
+    virtual void requestStop() {}
+
+    /**
+     * @brief 输出最近一次 grab() 的帧像素；grab() + retrieve() 与 read() 等价
+     *
+     * 实时源的采集循环持续 grab() 排空驱动队列，只在消费端需要时才 retrieve()，
+     * 因此实时源必须实现此方法。
+     * @param frame 输出帧（每次为新分配的缓冲区），格式见 pixelFormat()
+     */
+    virtual bool retrieve(cv::Mat& frame)
+    {
+        Q_UNUSED(frame);
+        return false;
+    }
+
+    /**
+     * @brief 输入源标称帧率，未知时返回0（打开后有效）
+     */
+    virtual double nominalFps() const { return 0.0; }
+
+    /**
+     * @brief 时长(毫秒)，未知或实时源返回-1（打开后有效）
+     */
+    virtual qint64 durationMs() const { return -1; }
+
+    /**
+     * @brief 回到开头，实时源返回false
+     */
+    virtual bool rewind() = 0;
+
+    /**
+     * @brief 定位到指定时间，之后的 read() 从该位置开始
+     * @param timestampMs 目标时间(毫秒)
+     * @param keyframeOnly 为true时停在目标之前最近的关键帧，不再向前解码（拖动预览用）
+     * @return 不支持定位时返回false
+     */
+    virtual bool seek(qint64 timestampMs, bool keyframeOnly)
+    {
+        Q_UNUSED(timestampMs);
+        Q_UNUSED(keyframeOnly);
+        return false;
+    }
+
+    /**
+     * @brief 用于日志和错误提示的描述
+     */
+    virtual QString description() const = 0;
+};
@@ -0,0 +1,279 @@
+#include "imagesequencesource.h"
+#include "taskscheduler.h"
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QWaitCondition>
+#include <atomic>
+#include <limits>
+
+namespace {
+
+// 内存映射文件后解码；映射失败时退回一次性读入
+bool decodeFile(const QString& path, cv::Mat& image)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const qint64 size = file.size();
+    if (size <= 0 || size > std::numeric_limits<int>::max()) {
+        return false;
+    }
+
+    QByteArray bytes;
+    uchar *data = file.map(0, size);
+    if (!data) {
+        bytes = file.readAll();
+        data = reinterpret_cast<uchar*>(bytes.data());
+    }
+
+    // 编码数据只读使用；尺寸和类型不变时 imdecode 直接写入 image 已有的缓冲
+    const cv::Mat encoded(1, static_cast<int>(size), CV_8UC1, data);
+    try {
+        cv::imdecode(encoded, cv::IMREAD_COLOR, &image);
+    } catch (const cv::Exception& e) {
+        qWarning() << "[ImageSequenceSource] 解码失败:" << path << e.what();
+        image.release();
+    }
+    return !image.empty();
+}
+
+} // namespace
+
+// 一张图像的解码任务：解码线程等待它完成，取消只对尚未开始的任务有效
+struct ImageSequenceSource::Pending {
+    int index = 0;
+    int slot = -1;                      // 输出缓冲在复用池中的位置
+    cv::Mat image;
+    bool ok = false;
+    bool done = false;
+    std::atomic<bool> cancelled{false};
+    QMutex mutex;
+    QWaitCondition finished;
+};
+
+ImageSequenceSource::ImageSequenceSource(const QStringList& files, double fps, int decodeAhead)
+    : m_files(files)
+    , m_fps(fps)
+    , m_decodeAhead(qMax(1, decodeAhead))
+{
+}
+
+ImageSequenceSource::~ImageSequenceSource()
+{
+    close();
+}
+
+bool ImageSequenceSource::open()
+{
+    if (m_opened) {
+        return true;
+    }
+    if (m_files.isEmpty()) {
+        qWarning() << "图像序列为空";
+        return false;
+    }
+    m_opened = true;
+    m_next = 0;
+    m_submitted = 0;
+    qDebug() << "Opened image sequence" << description() << "fps:" << m_fps;
+    return true;
+}
+
+void ImageSequenceSource::close()
+{
+    // 正在执行的任务持有自己的缓冲引用，不需要等待
+    cancelPending();
+    m_bufferPool.clear();
+    m_reserved.clear();
+    m_opened = false;
+}
+
+bool ImageSequenceSource::read(cv::Mat& frame, qint64& timestampMs)
+{
+    while (m_opened && m_next < m_files.size() && !m_stopRequested) {
+        fillWindow();
+        const std::shared_ptr<Pending> pending = m_pending.front();
+        {
+            QMutexLocker waiting(&m_waitingMutex);
+            m_waiting = pending;
+        }
+        bool done = false;
+        {
+            QMutexLocker locker(&pending->mutex);
+            while (!pending->done && !m_stopRequested) {
+                pending->finished.wait(&pending->mutex);
+            }
+            done = pending->done;
+        }
+        {
+            QMutexLocker waiting(&m_waitingMutex);
+            m_waiting.reset();
+        }
+        if (!done) {
+            // 停止时不再等待解码，未开始的任务全部取消
+            cancelPending();
+            return false;
+        }
+        m_pending.pop_front();
+
+        // 尺寸变化时 imdecode 会重新分配，池中记录新的缓冲
+        if (pending->slot >= 0) {
+            m_bufferPool[pending->slot] = pending->image;
+            m_reserved[pending->slot] = false;
+        }
+
+        const int index = m_next++;
+        if (!pending->ok) {
+            // 损坏或不支持的文件直接跳过，不中断整个序列
+            qWarning() << "无法解码图像：" << m_files[index];
+            continue;
+        }
+
+        frame = pending->image;
+        timestampMs = timestampOf(index);
+        fillWindow();
+        return true;
+    }
+    return false;
+}
+
+bool ImageSequenceSource::grab(qint64& timestampMs)
+{
+    if (!m_opened || m_next >= m_files.size() || m_stopRequested) {
+        return false;
+    }
+
+    // 跳过的图像不再解码
+    if (!m_pending.empty() && m_pending.front()->index == m_next) {
+        release(*m_pending.front());
+        m_pending.pop_front();
+    }
+    timestampMs = timestampOf(m_next++);
+    return true;
+}
+
+void ImageSequenceSource::requestStop()
+{
+    // 先置位再唤醒：read() 在任务的锁内检查标志，唤醒不会丢失
+    m_stopRequested = true;
+    QMutexLocker waiting(&m_waitingMutex);
+    if (m_waiting) {
+        QMutexLocker locker(&m_waiting->mutex);
+        m_waiting->finished.wakeAll();
+    }
+}
+
+bool ImageSequenceSource::rewind()
+{
+    if (!m_opened) {
+        return false;
+    }
+    cancelPending();
+    m_next = 0;
+    m_submitted = 0;
+    return true;
+}
+
+bool ImageSequenceSource::seek(qint64 timestampMs, bool keyframeOnly)
+{
+    // 每张图像都可以独立解码，关键帧模式与精确定位相同
+    Q_UNUSED(keyframeOnly);
+    if (!m_opened || m_fps <= 0.0) {
+        return false;
+    }
+    cancelPending();
+    m_next = qBound(0, static_cast<int>(timestampMs * m_fps / 1000.0), qMax(0, m_files.size() - 1));
+    m_submitted = m_next;
+    return true;
+}
+
+QString ImageSequenceSource::description() const
+{
+    if (m_files.isEmpty()) {
+        return "图像序列";
+    }
+    return QString("%1 (%2 张图像)").arg(QFileInfo(m_files.first()).absolutePath()).arg(m_files.size());
+}
+
+bool ImageSequenceSource::isImageFile(const QString& path)
+{
+    static const QStringList imageExtensions = {
+        "jpg", "jpeg", "jpe", "png", "bmp", "dib", "webp", "tif", "tiff", "pbm", "pgm", "ppm", "pnm"
+    };
+    return imageExtensions.contains(QFileInfo(path).suffix().toLower());
+}
+
+void ImageSequenceSource::fillWindow()
+{
+    m_submitted = qMax(m_submitted, m_next);
+    while (m_submitted < m_files.size() && m_submitted < m_next + m_decodeAhead) {
+        auto pending = std::make_shared<Pending>();
+        pending->index = m_submitted;
+        pending->slot = acquireBuffer(pending->image);
+        m_pending.push_back(pending);
+
+        const QString path = m_files[m_submitted++];
+        TaskScheduler::instance().submit([pending, path]() {
+            bool ok = false;
+            if (!pending->cancelled.load(std::memory_order_relaxed)) {
+                ok = decodeFile(path, pending->image);
+            }
+            QMutexLocker locker(&pending->mutex);
+            pending->ok = ok;
+            pending->done = true;
+            pending->finished.wakeAll();
+        });
+    }
+}
+
+void ImageSequenceSource::cancelPending()
+{
+    for (const auto& pending : m_pending) {
+        release(*pending);
+    }
+    m_pending.clear();
+    m_submitted = m_next;
+}
+
+void ImageSequenceSource::release(Pending& pending)
+{
+    // 取消的任务不写回，池中位置保留原缓冲；任务若已在执行，缓冲由它自己的引用保活
+    pending.cancelled = true;
+    if (pending.slot >= 0) {
+        m_reserved[pending.slot] = false;
+    }
+}
+
+int ImageSequenceSource::acquireBuffer(cv::Mat& buffer)
+{
+    // 只有池本身引用的缓冲才能复用：已发出的帧释放后引用计数回到1
+    for (size_t i = 0; i < m_bufferPool.size(); ++i) {
+        const cv::Mat& candidate = m_bufferPool[i];
+        const bool unused = candidate.empty() ? !m_reserved[i]
+                                              : candidate.u && candidate.u->refcount == 1;
+        if (unused) {
+            m_reserved[i] = true;
+            buffer = candidate;
+            return static_cast<int>(i);
+        }
+    }
+
+    // 解码窗口、预取缓冲和处理中的帧都可能持有缓冲，池的大小按解码窗口留出余量
+    buffer = cv::Mat();
+    const size_t limit = static_cast<size_t>(m_decodeAhead) * 2 + 8;
+    if (m_bufferPool.size() < limit) {
+        m_bufferPool.emplace_back();
+        m_reserved.push_back(true);
+        return static_cast<int>(m_bufferPool.size() - 1);
+    }
+    return -1;
+}
+
+qint64 ImageSequenceSource::timestampOf(int index) const
+{
+    // 不按时间播放时时间戳只需单调递增
+    return m_fps > 0.0 ? qRound64(index * 1000.0 / m_fps) : index;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <QMutex>
+#include <QStringList>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+#include "framesource.h"
+
+/**
+ * @class ImageSequenceSource
+ * @brief 把一组静态图像作为帧流播放的输入源
+ *
+ * 图像文件用 QFile::map 内存映射后交给 cv::imdecode 解码，解码任务提交到共享线程池，
+ * 在播放位置之前并行解码若干张；输出缓冲来自复用池，尺寸不变时不重新分配。
+ * 时间戳按设定帧率生成，帧率 <= 0 时不按时间播放（由 Reader 尽快发送）。
+ */
+class ImageSequenceSource : public FrameSource {
+public:
+    /**
+     * @param files 按播放顺序排列的图像文件
+     * @param fps 播放帧率，<=0 表示不按时间播放
+     * @param decodeAhead 同时在线程池中解码的图像数
+     */
+    ImageSequenceSource(const QStringList& files, double fps, int decodeAhead);
+    ~ImageSequenceSource() override;
+
+    bool open() override;
+    void close() override;
+    bool isOpened() const override { return m_opened; }
+    bool isLive() const override { return false; }
+    bool read(cv::Mat& frame, qint64& timestampMs) override;
+    bool grab(qint64& timestampMs) override;
+    void requestStop() override;
+    bool rewind() override;
+    bool seek(qint64 timestampMs, bool keyframeOnly) override;
+    QString description() const override;
+    double nominalFps() const override { return m_fps > 0.0 ? m_fps : 0.0; }
+    qint64 durationMs() const override { return m_fps > 0.0 ? timestampOf(m_files.size()) : -1; }
+
+    /**
+     * @brief 判断文件是否为支持的图像格式（按扩展名）
+     */
+    static bool isImageFile(const QString& path);
+
+private:
+    struct Pending;
+
+    /**
+     * @brief 补足解码窗口：为播放位置之后的图像提交解码任务
+     */
+    void fillWindow();
+
+    /**
+     * @brief 取消所有未开始的解码任务
+     */
+    void cancelPending();
+
+    /**
+     * @brief 取消一个解码任务并归还它在复用池中的位置
+     */
+    void release(Pending& pending);
+
+    /**
+     * @brief 从复用池取一块当前没有被任何帧引用的缓冲
+     * @return 缓冲在池中的位置，池已满时返回-1（使用新分配的缓冲）
+     */
+    int acquireBuffer(cv::Mat& buffer);
+
+    qint64 timestampOf(int index) const;
+
+    const QStringList m_files;
+    const double m_fps;
+    const int m_decodeAhead;
+    bool m_opened = false;
+    int m_next = 0;                                 ///< 下一帧（播放位置）的下标
+    int m_submitted = 0;                            ///< 已提交解码的下一个下标
+    std::deque<std::shared_ptr<Pending>> m_pending; ///< 已提交、按下标排列的解码任务
+    std::vector<cv::Mat> m_bufferPool;              ///< 输出缓冲复用池
+    std::vector<bool> m_reserved;                   ///< 池中位置已交给解码任务、尚未写回
+    std::atomic<bool> m_stopRequested{false};
+    QMutex m_waitingMutex;
+    std::shared_ptr<Pending> m_waiting;             ///< read() 正在等待的任务，requestStop() 唤醒它
+};
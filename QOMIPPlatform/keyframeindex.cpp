@@ -0,0 +1,246 @@
+#include "keyframeindex.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStandardPaths>
+#include <algorithm>
+#include <opencv2/opencv.hpp>
+
+// OpenCV 4.7 起 FFmpeg 后端可以只解复用（CAP_PROP_FORMAT=-1）并报告数据包是否为关键帧
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR >= 7)
+#  define QOMIP_HAS_RAW_KEYFRAMES 1
+#endif
+
+namespace {
+
+const int kIndexVersion = 1;
+
+} // namespace
+
+KeyframeIndex::Keyframe KeyframeIndex::keyframeAtOrBefore(qint64 timestampMs) const
+{
+    auto it = std::upper_bound(m_keyframes.begin(), m_keyframes.end(), timestampMs,
+                               [](qint64 ms, const Keyframe& key) { return ms < key.timestampMs; });
+    if (it == m_keyframes.begin()) {
+        return Keyframe();
+    }
+    return *(it - 1);
+}
+
+int KeyframeIndex::frameAt(qint64 timestampMs) const
+{
+    const Keyframe key = keyframeAtOrBefore(timestampMs);
+    const double fps = m_fps > 0.0 ? m_fps : 30.0;
+    const int frame = key.frame + qRound((timestampMs - key.timestampMs) * fps / 1000.0);
+    return qBound(0, frame, qMax(0, m_frameCount - 1));
+}
+
+QString KeyframeIndex::cachePath(const QString& mediaPath)
+{
+    const QByteArray hash = QCryptographicHash::hash(QFileInfo(mediaPath).absoluteFilePath().toUtf8(),
+                                                     QCryptographicHash::Sha1).toHex();
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+           + "/keyframes/" + QString::fromLatin1(hash) + ".json";
+}
+
+KeyframeIndex KeyframeIndex::load(const QString& mediaPath)
+{
+    QFile file(cachePath(mediaPath));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return KeyframeIndex();
+    }
+
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    const QFileInfo info(mediaPath);
+    if (root.value("version").toInt() != kIndexVersion
+        || root.value("size").toVariant().toLongLong() != info.size()
+        || root.value("modified").toVariant().toLongLong() != info.lastModified().toMSecsSinceEpoch()) {
+        return KeyframeIndex();     // 文件已变化
+    }
+
+    KeyframeIndex index;
+    index.m_frameCount = root.value("frames").toInt();
+    index.m_fps = root.value("fps").toDouble();
+    index.m_durationMs = root.value("duration").toVariant().toLongLong();
+    const QJsonArray keyframes = root.value("keyframes").toArray();
+    index.m_keyframes.reserve(keyframes.size());
+    for (const QJsonValue& value : keyframes) {
+        const QJsonArray pair = value.toArray();
+        Keyframe key;
+        key.frame = pair.at(0).toInt();
+        key.timestampMs = pair.at(1).toVariant().toLongLong();
+        index.m_keyframes.push_back(key);
+    }
+    return index;
+}
+
+bool KeyframeIndex::save(const QString& mediaPath) const
+{
+    const QString path = cachePath(mediaPath);
+    if (!QDir().mkpath(QFileInfo(path).absolutePath())) {
+        return false;
+    }
+
+    const QFileInfo info(mediaPath);
+    QJsonObject root;
+    root.insert("version", kIndexVersion);
+    root.insert("path", info.absoluteFilePath());
+    root.insert("size", QString::number(info.size()));
+    root.insert("modified", QString::number(info.lastModified().toMSecsSinceEpoch()));
+    root.insert("frames", m_frameCount);
+    root.insert("fps", m_fps);
+    root.insert("duration", QString::number(m_durationMs));
+    QJsonArray keyframes;
+    for (const Keyframe& key : m_keyframes) {
+        keyframes.append(QJsonArray{key.frame, QString::number(key.timestampMs)});
+    }
+    root.insert("keyframes", keyframes);
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    return true;
+}
+
+KeyframeIndex KeyframeIndex::build(const QString& mediaPath, const std::atomic<bool>& cancel)
+{
+    KeyframeIndex index;
+    cv::VideoCapture cap;
+    bool raw = false;
+#ifdef QOMIP_HAS_RAW_KEYFRAMES
+    raw = cap.open(mediaPath.toStdString(), cv::CAP_FFMPEG, {cv::CAP_PROP_FORMAT, -1});
+#endif
+    if (!raw && !cap.open(mediaPath.toStdString())) {
+        return index;
+    }
+
+    index.m_fps = cap.get(cv::CAP_PROP_FPS);
+    if (!(index.m_fps > 0.0 && index.m_fps < 1000.0)) {
+        index.m_fps = 0.0;
+    }
+
+    if (!raw) {
+        // 逐帧解码扫描太慢：只记录帧数和帧率，定位交给后端
+        index.m_frameCount = static_cast<int>(cap.get(cv::CAP_PROP_FRAME_COUNT));
+        if (index.m_fps > 0.0) {
+            index.m_durationMs = qRound64(index.m_frameCount * 1000.0 / index.m_fps);
+        }
+        return index;
+    }
+
+#ifdef QOMIP_HAS_RAW_KEYFRAMES
+    // 只读取数据包，不解码
+    int frame = 0;
+    qint64 lastTimestamp = -1;
+    while (!cancel.load(std::memory_order_relaxed) && cap.grab()) {
+        qint64 timestamp = static_cast<qint64>(cap.get(cv::CAP_PROP_POS_MSEC));
+        if (timestamp <= lastTimestamp && index.m_fps > 0.0) {
+            timestamp = qMax(lastTimestamp + 1, qRound64(frame * 1000.0 / index.m_fps));
+        }
+        lastTimestamp = timestamp;
+        if (cap.get(cv::CAP_PROP_LRF_HAS_KEY_FRAME) != 0.0) {
+            index.m_keyframes.push_back(Keyframe{frame, timestamp});
+        }
+        ++frame;
+    }
+    if (cancel.load(std::memory_order_relaxed)) {
+        return KeyframeIndex();
+    }
+    index.m_frameCount = frame;
+    index.m_durationMs = lastTimestamp + (index.m_fps > 0.0 ? qRound64(1000.0 / index.m_fps) : 0);
+#endif
+    return index;
+}
+
+KeyframeIndexer& KeyframeIndexer::instance()
+{
+    static KeyframeIndexer indexer;
+    return indexer;
+}
+
+KeyframeIndexer::~KeyframeIndexer()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_wakeup.wakeAll();
+    }
+    if (m_thread) {
+        m_thread->wait();
+        delete m_thread;
+    }
+}
+
+QString KeyframeIndexer::keyOf(const QString& mediaPath)
+{
+    const QString canonical = QFileInfo(mediaPath).canonicalFilePath();
+    return canonical.isEmpty() ? mediaPath : canonical;
+}
+
+void KeyframeIndexer::request(const QString& mediaPath)
+{
+    const QString key = keyOf(mediaPath);
+    QMutexLocker locker(&m_mutex);
+    if (m_ready.contains(key) || m_queue.contains(key)) {
+        return;
+    }
+    m_queue.append(key);
+    if (!m_thread) {
+        m_thread = QThread::create([this]() { run(); });
+        m_thread->setObjectName("KeyframeIndexer");
+        m_thread->start(QThread::LowPriority);
+    }
+    m_wakeup.wakeAll();
+}
+
+std::shared_ptr<const KeyframeIndex> KeyframeIndexer::find(const QString& mediaPath) const
+{
+    const QString key = keyOf(mediaPath);
+    QMutexLocker locker(&m_mutex);
+    return m_ready.value(key);
+}
+
+void KeyframeIndexer::run()
+{
+    while (true) {
+        QString path;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (!m_stopping && m_queue.isEmpty()) {
+                m_wakeup.wait(&m_mutex);
+            }
+            if (m_stopping) {
+                break;
+            }
+            path = m_queue.first();     // 处理完成后才出队，避免重复请求
+        }
+
+        // 优先使用缓存，没有时扫描文件并写入缓存
+        KeyframeIndex index = KeyframeIndex::load(path);
+        if (!index.isValid()) {
+            index = KeyframeIndex::build(path, m_stopping);
+            if (index.isValid() && !index.save(path)) {
+                qWarning() << "[KeyframeIndexer] 无法写入索引缓存:" << KeyframeIndex::cachePath(path);
+            }
+        }
+        if (index.isValid()) {
+            qDebug() << "[KeyframeIndexer]" << path << "frames:" << index.frameCount()
+                     << "keyframes:" << index.keyframes().size();
+        }
+
+        QMutexLocker locker(&m_mutex);
+        m_queue.removeAll(path);
+        // 失败不记录：文件可能还在写入或暂时不可读，下次打开时重新尝试
+        if (index.isValid()) {
+            m_ready.insert(path, std::make_shared<const KeyframeIndex>(std::move(index)));
+        }
+    }
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <QWaitCondition>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+/**
+ * @class KeyframeIndex
+ * @brief 视频文件的关键帧/时间戳索引
+ *
+ * 只解复用、不解码地扫描一遍文件，记录每个关键帧的帧号和时间戳。
+ * 索引以JSON缓存在 QStandardPaths::CacheLocation/keyframes 下，
+ * 按文件大小和修改时间校验，文件变化后重新建立。
+ */
+class KeyframeIndex {
+public:
+    struct Keyframe {
+        int frame = 0;              ///< 帧号（从0开始）
+        qint64 timestampMs = 0;     ///< 显示时间戳(毫秒)
+    };
+
+    bool isValid() const { return m_frameCount > 0; }
+
+    /**
+     * @brief 是否记录了关键帧；OpenCV 无法报告关键帧标志时只有帧数和帧率
+     */
+    bool hasKeyframes() const { return !m_keyframes.empty(); }
+
+    int frameCount() const { return m_frameCount; }
+    double fps() const { return m_fps; }
+    qint64 durationMs() const { return m_durationMs; }
+    const std::vector<Keyframe>& keyframes() const { return m_keyframes; }
+
+    /**
+     * @brief 时间戳不晚于 timestampMs 的最后一个关键帧（没有时返回第0帧）
+     */
+    Keyframe keyframeAtOrBefore(qint64 timestampMs) const;
+
+    /**
+     * @brief 时间戳对应的帧号：从之前的关键帧按帧率推算
+     */
+    int frameAt(qint64 timestampMs) const;
+
+    /**
+     * @brief 从缓存读取索引，缓存不存在或与文件不符时返回无效索引
+     */
+    static KeyframeIndex load(const QString& mediaPath);
+
+    /**
+     * @brief 扫描文件建立索引（耗时，在后台线程调用）
+     * @param cancel 置为true时尽快返回无效索引
+     */
+    static KeyframeIndex build(const QString& mediaPath, const std::atomic<bool>& cancel);
+
+    /**
+     * @brief 写入缓存
+     */
+    bool save(const QString& mediaPath) const;
+
+    /**
+     * @brief 文件对应的缓存路径
+     */
+    static QString cachePath(const QString& mediaPath);
+
+private:
+    int m_frameCount = 0;
+    double m_fps = 0.0;
+    qint64 m_durationMs = 0;
+    std::vector<Keyframe> m_keyframes;      // 按帧号递增
+};
+
+/**
+ * @class KeyframeIndexer
+ * @brief 在后台线程中加载或建立关键帧索引的进程内服务
+ *
+ * 打开文件源时 request()，解码线程在定位时 find() 取用已就绪的索引；
+ * 索引尚未就绪时 find() 返回空，调用方退回后端自身的定位方式。
+ * 所有接口都是线程安全的，所有文件共用一个索引线程。
+ */
+class KeyframeIndexer {
+public:
+    static KeyframeIndexer& instance();
+
+    /**
+     * @brief 请求为文件准备索引（已就绪或已在队列中时不重复处理，上次失败时重新尝试）
+     */
+    void request(const QString& mediaPath);
+
+    /**
+     * @brief 已就绪的索引，尚未就绪时返回nullptr
+     */
+    std::shared_ptr<const KeyframeIndex> find(const QString& mediaPath) const;
+
+private:
+    KeyframeIndexer() = default;
+    ~KeyframeIndexer();
+    KeyframeIndexer(const KeyframeIndexer&) = delete;
+    KeyframeIndexer& operator=(const KeyframeIndexer&) = delete;
+
+    void run();
+    static QString keyOf(const QString& mediaPath);
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_wakeup;
+    QStringList m_queue;                                        // 等待处理的文件（规范化路径）
+    QHash<QString, std::shared_ptr<const KeyframeIndex>> m_ready;  // 只保存有效的索引
+    std::atomic<bool> m_stopping{false};
+    QThread *m_thread = nullptr;
+};
@@ -1,6 +1,10 @@
 #include "mainwindow.h"
 #include "basicviewwidget.h"
+#include "sharedframe.h"
+#include "taskscheduler.h"
+#include "sharedprefixcache.h"
 #include <QApplication>
+#include <QSettings>
 
 int main(int argc, char *argv[])
 {
@@ -8,13 +12,35 @@ int main(int argc, char *argv[])
 
     
     QApplication a(argc, argv);
-    MainWindow w;
-    w.show();
-    // BasicViewWidget w;
-    // w.show();
-    // cv::Mat mat= cv::imread("/home/fylove/Pictures/4.jpg");
+    
+    // 跨线程队列连接传递的共享帧类型
+    qRegisterMetaType<SharedFrame>("SharedFrame");
+    
+    // 启动所有视图共享的线程池，并接管OpenCV的parallel_for_
+    // worker_count <= 0 时按CPU核心数自动选择
+    QSettings schedulerSettings("QOMIPPlatform", "Scheduler");
+    TaskScheduler::instance().start(schedulerSettings.value("worker_count", 0).toInt());
+    if (schedulerSettings.value("opencv_backend", true).toBool()) {
+        TaskScheduler::instance().installOpenCVBackend();
+    }
+    
+    // 跨视图公共前缀结果保留的帧数
+    SharedPrefixCache::instance().setWindow(schedulerSettings.value("prefix_cache_frames", 3).toInt());
+    
+    int ret = 0;
+    {
+        MainWindow w;
+        w.show();
+        // BasicViewWidget w;
+        // w.show();
+        // cv::Mat mat= cv::imread("/home/fylove/Pictures/4.jpg");
 
 
-    // w.setImage(mat);
-    return a.exec();
+        // w.setImage(mat);
+        ret = a.exec();
+    }
+    
+    // 所有视图销毁后再停止线程池
+    TaskScheduler::instance().shutdown();
+    return ret;
 }
@@ -5,6 +5,8 @@
 #include "CustomerAlg/mobilenetssdprocessor.h"
 #include "resourceextractor.h"
 #include "exportprogressdialog.h"
+#include "imagesequencesource.h"
+#include "wallview.h"
 #include <QMessageBox>
 #include <QGraphicsPixmapItem>
 #include <QDragEnterEvent>
@@ -25,6 +27,9 @@
 #include <QThread>
 #include <QApplication>
 #include <QFile>
+#include <QCollator>
+#include <algorithm>
+#include <limits>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -39,9 +44,32 @@ MainWindow::MainWindow(QWidget *parent)
     // 启用拖放
     setAcceptDrops(true);
 
+    // 信用池需要在创建视图之前创建，视图的处理器会注册到其中
+    m_creditPool = new FrameCreditPool(this);
+    
+    // 解码服务为绑定了独立输入源的视图供帧，同一输入源只解码一次
+    m_decodeService = new DecodeService(this);
+    connect(m_decodeService, &DecodeService::streamFinished, this,
+            [this](const QString &source, const QString &message) {
+        statusBar()->showMessage(QString("%1: %2").arg(source, message), 5000);
+    });
+
+    // 不可见视图默认降频处理，可配置为暂停
+    QSettings schedulerSettings("QOMIPPlatform", "Scheduler");
+    m_hiddenViewPriority = schedulerSettings.value("hidden_view_policy", "background").toString() == "paused"
+        ? ViewPriority::Paused : ViewPriority::Background;
+
     // 初始化界面
     initAll();
     
+    // 视频墙：打开后所有视图都按可见处理，关闭窗口时同步菜单勾选
+    m_wallView = new WallView(this);
+    m_wallView->setViews(m_vectorWidget);
+    connect(m_wallView, &WallView::visibilityChanged, this, [this]() {
+        ui->actionVideo_Wall->setChecked(m_wallView->isVisible());
+        updateViewPriorities();
+    });
+    
     // 创建摄像头管理器
     m_cameraManager = new CameraManager(this);
     
@@ -55,6 +83,11 @@ MainWindow::MainWindow(QWidget *parent)
     // 设置Reader需要处理的窗口数量
     m_reader->setViewCount(currentWidetCount);
     
+    // 处理器全部饱和时Reader跳过解码，有空位时恢复
+    m_reader->setCreditPool(m_creditPool);
+    connect(m_creditPool, &FrameCreditPool::creditsAvailable,
+            m_reader, &Reader::onCreditsAvailable);
+    
     // 将Reader移动到线程中
     m_reader->moveToThread(m_readerThread);
     
@@ -63,11 +96,16 @@ MainWindow::MainWindow(QWidget *parent)
             this, &MainWindow::on_Reader_FrameReady);
     connect(m_reader, &Reader::processingFinished,
             this, &MainWindow::onProcessingFinished);
+    connect(m_reader, &Reader::playlistIndexChanged,
+            this, &MainWindow::onPlaylistIndexChanged);
     
     // 连接摄像头管理器信号
     connect(m_cameraManager, &CameraManager::camerasUpdated,
             this, &MainWindow::onCamerasUpdated);
     
+    // 播放位置条：跟随Reader报告的位置，拖动定位
+    initSeekBar();
+    
     // 启动线程
     m_readerThread->start();
 
@@ -85,6 +123,10 @@ MainWindow::MainWindow(QWidget *parent)
 
     connect(ui->playButton, &QPushButton::clicked, this, &MainWindow::on_playButton_clicked);
     
+    // 切换标签页时只让当前可见的视图全速处理
+    connect(ui->videoWidget, &QTabWidget::currentChanged, this, &MainWindow::updateViewPriorities);
+    updateViewPriorities();
+    
     // 应用启动时扫描摄像头
     QTimer::singleShot(500, this, [this]() {
         refreshCameras();
@@ -100,6 +142,10 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    // 先停止各独立输入源，视图随后随窗口销毁
+    delete m_decodeService;
+    m_decodeService = nullptr;
+    
     // 确保线程安全退出
     if (m_readerThread->isRunning()) {
         // 通过线程安全的方式停止处理
@@ -134,12 +180,44 @@ void MainWindow::initAll()
     for(int i = 0; i < currentWidetCount; i++){
         BasicViewWidget* widget = new BasicViewWidget(this);
         widget->setObjectName(QString("Video%1").arg(i+1));
+        registerViewWidget(widget);
         m_vectorWidget.push_back(widget);
         ui->videoWidget->addTab(widget, QString("Video%1").arg(i+1));
     }
     qDebug()<<"[MainWindow]: initAll Down. CurrentCount = " << currentWidetCount;
 }
 
+void MainWindow::registerViewWidget(BasicViewWidget *widget)
+{
+    // 默认跟随主输入源，受主Reader的背压控制
+    m_creditPool->addConsumer(widget->m_processor);
+    connect(widget, &BasicViewWidget::sourceChangeRequested,
+            this, &MainWindow::onViewSourceRequested);
+}
+
+void MainWindow::onViewSourceRequested(BasicViewWidget *view, const SourceSpec &source)
+{
+    if (!view || !m_decodeService) {
+        return;
+    }
+    
+    // 绑定独立输入源的视图从主输入源的信用池中移出，由该输入源的信用池控制
+    const bool wasBound = m_decodeService->isBound(view);
+    m_decodeService->bind(view, source);
+    if (source.isNull() && wasBound) {
+        m_creditPool->addConsumer(view->m_processor);
+    } else if (!source.isNull() && !wasBound) {
+        m_creditPool->removeConsumer(view->m_processor);
+    }
+    view->setBoundSource(source);
+    
+    const int tabIndex = ui->videoWidget->indexOf(view);
+    if (tabIndex >= 0) {
+        ui->videoWidget->setTabToolTip(tabIndex, source.displayName());
+    }
+    statusBar()->showMessage(QString("%1 输入源: %2").arg(view->getWidgetName(), source.displayName()), 3000);
+}
+
 void MainWindow::initCameraUI()
 {
     // 获取Camera标签页
@@ -210,6 +288,23 @@ void MainWindow::initCameraUI()
     
     layout->addWidget(refreshButton);
     
+    // 没有摄像头时用视频文件模拟：按帧率实时出帧，验证实时采集路径和延迟
+    QPushButton* emulateButton = new QPushButton("用视频文件模拟摄像头...", cameraTab);
+    connect(emulateButton, &QPushButton::clicked, this, [this]() {
+        const QString file = QFileDialog::getOpenFileName(
+            this, "选择模拟摄像头的视频文件", QString(),
+            "视频文件 (*.mp4 *.avi *.mov *.wmv *.flv *.mkv *.webm *.m4v *.3gp *.mpg *.mpeg);;所有文件 (*)");
+        if (file.isEmpty()) {
+            return;
+        }
+        // 取消列表选择，播放按钮沿用当前设置的源
+        ui->V_ListWidget->setCurrentItem(nullptr);
+        m_cameraListWidget->setCurrentItem(nullptr);
+        m_reader->setEmulatedCameraSource(file);
+        statusBar()->showMessage(QString("已选择模拟摄像头: %1").arg(QFileInfo(file).fileName()), 3000);
+    });
+    layout->addWidget(emulateButton);
+    
     // 添加提示标签
     QLabel* hintLabel = new QLabel("提示：选择摄像头后点击播放按钮开始预览", cameraTab);
     hintLabel->setStyleSheet("color: #666; font-size: 12px; padding: 5px;");
@@ -288,6 +383,106 @@ void MainWindow::onCameraListItemClicked(QListWidgetItem *item)
     qDebug() << "Selected camera index:" << cameraIndex;
 }
 
+void MainWindow::initSeekBar()
+{
+    m_seekSlider = new QSlider(Qt::Horizontal, this);
+    m_seekSlider->setRange(0, 0);
+    m_seekSlider->setEnabled(false);
+    m_seekSlider->setMinimumWidth(240);
+    m_positionLabel = new QLabel("--:-- / --:--", this);
+    statusBar()->addPermanentWidget(m_seekSlider);
+    statusBar()->addPermanentWidget(m_positionLabel);
+    
+    connect(m_reader, &Reader::positionChanged, this, &MainWindow::onReaderPositionChanged);
+    
+    // 拖动期间暂停播放，只解码关键帧预览；松开后精确定位并恢复播放
+    connect(m_seekSlider, &QSlider::sliderPressed, this, [this]() {
+        m_resumeAfterScrub = ui->playButton->isChecked();
+        if (m_resumeAfterScrub) {
+            QMetaObject::invokeMethod(m_reader, "pause", Qt::QueuedConnection);
+        }
+    });
+    connect(m_seekSlider, &QSlider::sliderMoved, this, [this](int value) {
+        QMetaObject::invokeMethod(m_reader, "scrub", Qt::QueuedConnection, Q_ARG(qint64, value));
+        updatePositionLabel(value, m_seekSlider->maximum());
+    });
+    connect(m_seekSlider, &QSlider::sliderReleased, this, [this]() {
+        QMetaObject::invokeMethod(m_reader, "seek", Qt::QueuedConnection,
+                                  Q_ARG(qint64, m_seekSlider->value()));
+        if (m_resumeAfterScrub) {
+            QMetaObject::invokeMethod(m_reader, "play", Qt::QueuedConnection);
+        }
+    });
+    
+    // 点击滑槽或键盘翻页直接精确定位
+    connect(m_seekSlider, &QSlider::actionTriggered, this, [this](int action) {
+        if (action != QAbstractSlider::SliderMove && action != QAbstractSlider::SliderNoAction) {
+            QMetaObject::invokeMethod(m_reader, "seek", Qt::QueuedConnection,
+                                      Q_ARG(qint64, m_seekSlider->sliderPosition()));
+        }
+    });
+}
+
+void MainWindow::onReaderPositionChanged(qint64 timestampMs, qint64 durationMs)
+{
+    // 实时源或时长未知时不能定位
+    const bool seekable = durationMs > 0;
+    m_seekSlider->setEnabled(seekable);
+    if (!seekable) {
+        m_seekSlider->setRange(0, 0);
+        if (m_reader->getSourceType() == Reader::SOURCE_CAMERA) {
+            // 实时源显示采集到显示的延迟（跟随主输入源的视图中最大的平均值）
+            qint64 latencyUs = -1;
+            for (BasicViewWidget *view : std::as_const(m_vectorWidget)) {
+                if (view->boundSource().isNull()) {
+                    latencyUs = qMax(latencyUs, view->captureLatency().averageUs);
+                }
+            }
+            m_positionLabel->setText(latencyUs >= 0
+                                     ? QString("实时 · 延迟 %1 ms").arg(latencyUs / 1000.0, 0, 'f', 1)
+                                     : QString("实时"));
+            m_positionLabel->setToolTip(QString());
+            return;
+        }
+        updatePositionLabel(timestampMs, -1);
+        appendPlaybackStats();
+        return;
+    }
+    
+    // 拖动中不跟随，避免滑块跳回
+    if (m_seekSlider->isSliderDown()) {
+        return;
+    }
+    m_seekSlider->setRange(0, static_cast<int>(qMin<qint64>(durationMs, std::numeric_limits<int>::max())));
+    m_seekSlider->setValue(static_cast<int>(qMin<qint64>(timestampMs, m_seekSlider->maximum())));
+    updatePositionLabel(timestampMs, durationMs);
+    appendPlaybackStats();
+}
+
+void MainWindow::appendPlaybackStats()
+{
+    // 文件源按播放时钟发帧：处理跟不上时丢弃或跳过的帧数显示在位置之后，延迟放在提示中
+    const Reader::PlaybackStats stats = m_reader->playbackStats();
+    const quint64 dropped = stats.lateFrames + stats.skippedFrames;
+    if (dropped > 0) {
+        m_positionLabel->setText(m_positionLabel->text() + QString(" · 丢帧 %1").arg(dropped));
+    }
+    m_positionLabel->setToolTip(QString("帧率 %1 fps\n延迟 %2 ms（最大 %3 ms）\n过期丢弃 %4 帧，处理饱和跳过 %5 帧")
+                                .arg(stats.sourceFps, 0, 'f', 1)
+                                .arg(stats.driftMs).arg(stats.maxDriftMs)
+                                .arg(stats.lateFrames).arg(stats.skippedFrames));
+}
+
+void MainWindow::updatePositionLabel(qint64 timestampMs, qint64 durationMs)
+{
+    auto format = [](qint64 ms) {
+        const qint64 seconds = qMax<qint64>(0, ms) / 1000;
+        return QString("%1:%2").arg(seconds / 60, 2, 10, QChar('0')).arg(seconds % 60, 2, 10, QChar('0'));
+    };
+    m_positionLabel->setText(durationMs > 0 ? format(timestampMs) + " / " + format(durationMs)
+                                            : format(timestampMs) + " / --:--");
+}
+
 void MainWindow::on_playButton_clicked()
 {
     bool sourceChanged = false;
@@ -296,9 +491,29 @@ void MainWindow::on_playButton_clicked()
     QListWidgetItem* currentItem = ui->V_ListWidget->currentItem();
     if (currentItem) {
         QString filePath = currentItem->text();
+        if (ImageSequenceSource::isImageFile(filePath)) {
+            // 图像文件：把列表中同一目录下的图像作为序列播放
+            const QStringList images = imageSequenceFor(filePath);
+            if (m_reader->getSourceType() != Reader::SOURCE_IMAGES ||
+                m_reader->getCurrentImageSequence() != images) {
+                m_reader->setImageSequence(images);
+                sourceChanged = true;
+            }
+        }
+        else if (m_playlistMode && videoPlaylist().contains(filePath)) {
+            // 列表模式：从选中的文件开始连续播放列表中的所有视频
+            const QStringList playlist = videoPlaylist();
+            if (m_reader->getSourceType() != Reader::SOURCE_FILE ||
+                m_reader->getCurrentSourcePath() != filePath ||
+                m_reader->getCurrentPlaylist() != playlist) {
+                m_reader->setPlaylist(playlist, playlist.indexOf(filePath));
+                sourceChanged = true;
+            }
+        }
         // 检查是否与当前源不同
-        if (m_reader->getSourceType() != Reader::SOURCE_FILE || 
-            m_reader->getCurrentSourcePath() != filePath) {
+        else if (m_reader->getSourceType() != Reader::SOURCE_FILE || 
+            m_reader->getCurrentSourcePath() != filePath ||
+            !m_reader->getCurrentPlaylist().isEmpty()) {
             m_reader->setSource(filePath);
             sourceChanged = true;
         }
@@ -314,7 +529,7 @@ void MainWindow::on_playButton_clicked()
                 m_reader->setCameraSource(cameraIndex);
                 sourceChanged = true;
             }
-        } else if (m_reader->getSourceType() == Reader::SOURCE_NONE) {
+        } else if (m_reader->getSourceType() == Reader::SOURCE_NONE && m_decodeService->streamCount() == 0) {
             // 没有任何源可用
             QMessageBox::warning(this, "警告", "请先选择视频文件或摄像头");
             return;
@@ -333,7 +548,10 @@ void MainWindow::on_playButton_clicked()
         ui->playButton->setStyleSheet("QPushButton { background-color: #f44336; }");
         
         // 通过线程安全的方式调用play方法
-        QMetaObject::invokeMethod(m_reader, "play", Qt::QueuedConnection);
+        if (m_reader->getSourceType() != Reader::SOURCE_NONE) {
+            QMetaObject::invokeMethod(m_reader, "play", Qt::QueuedConnection);
+        }
+        m_decodeService->setPlaying(true);
         
         qDebug() << "[MainWindow]: 开始播放";
     } else {
@@ -343,21 +561,23 @@ void MainWindow::on_playButton_clicked()
         
         // 通过线程安全的方式调用pause方法
         QMetaObject::invokeMethod(m_reader, "pause", Qt::QueuedConnection);
+        m_decodeService->setPlaying(false);
         
         qDebug() << "[MainWindow]: 暂停播放";
     }
 }
 
-void MainWindow::on_Reader_FrameReady(const cv::Mat &frame)
+void MainWindow::on_Reader_FrameReady(const SharedFrame &frame)
 {
-    // 将帧分发给所有视图窗口进行处理
+    // 获取当前选中的widget索引
+    const int currentTabIndex = ui->videoWidget->currentIndex();
+    
+    // 将同一个共享帧分发给所有跟随主输入源的视图窗口，不拷贝像素
     for(int i = 0; i < m_vectorWidget.size(); i++) {
-        if(m_vectorWidget[i]) {
-            // 获取当前选中的widget索引
-            int currentTabIndex = ui->videoWidget->currentIndex();
+        if(m_vectorWidget[i] && !m_decodeService->isBound(m_vectorWidget[i])) {
             bool isCurrentWidget = (i == currentTabIndex);
             
-            cv::Mat processedFrame = frame;
+            SharedFrame processedFrame = frame;
             
             // 如果是当前选中的widget且启用了MobileNet SSD模式，使用SSD处理
             if (isCurrentWidget && 
@@ -365,7 +585,7 @@ void MainWindow::on_Reader_FrameReady(const cv::Mat &frame)
                 m_ssdProcessor->isModelLoaded()) {
                 
                 try {
-                    processedFrame = m_ssdProcessor->processFrame(frame);
+                    processedFrame = frame.derive(m_ssdProcessor->processFrame(frame.image()));
                 } catch (const std::exception& e) {
                     qDebug() << "[MainWindow] MobileNet SSD处理异常:" << e.what();
                     // 发生异常时使用原始帧
@@ -377,6 +597,46 @@ void MainWindow::on_Reader_FrameReady(const cv::Mat &frame)
             m_vectorWidget[i]->processFrame(processedFrame);
         }
     }
+    
+    // 帧已进入各处理器队列，不再计为在途帧
+    m_creditPool->releaseFrame();
+}
+
+void MainWindow::on_actionMax_Throughput_toggled(bool checked)
+{
+    // 最大吞吐模式：文件源不按帧率定时，处理端一有空位就读取下一帧
+    QMetaObject::invokeMethod(m_reader, "setMaxThroughput", Qt::QueuedConnection,
+                              Q_ARG(bool, checked));
+    m_decodeService->setMaxThroughput(checked);
+    statusBar()->showMessage(checked ? "最大吞吐模式：按处理速度读取" : "按视频帧率播放", 3000);
+}
+
+void MainWindow::on_actionPlaylist_Mode_toggled(bool checked)
+{
+    // 下次点击播放时生效
+    m_playlistMode = checked;
+    statusBar()->showMessage(checked ? "列表模式：连续播放列表中的所有视频" : "单个文件播放", 3000);
+}
+
+void MainWindow::on_actionVideo_Wall_toggled(bool checked)
+{
+    m_wallView->setVisible(checked);
+    if (checked) {
+        m_wallView->raise();
+        m_wallView->activateWindow();
+    }
+}
+
+void MainWindow::onPlaylistIndexChanged(int index, const QString &path)
+{
+    // 列表中选中正在播放的文件，再次点击播放按钮时不会被当作换源
+    for (int row = 0; row < ui->V_ListWidget->count(); ++row) {
+        if (ui->V_ListWidget->item(row)->text() == path) {
+            ui->V_ListWidget->setCurrentRow(row);
+            break;
+        }
+    }
+    statusBar()->showMessage(QString("播放列表 %1: %2").arg(index + 1).arg(QFileInfo(path).fileName()), 3000);
 }
 
 void MainWindow::onProcessingFinished(const QString &message)
@@ -424,6 +684,7 @@ void MainWindow::on_actionDelete_Current_Widget_triggered()
     
     // 更新Reader的视图数量
     m_reader->setViewCount(currentWidetCount);
+    m_wallView->setViews(m_vectorWidget);
     
     qDebug() << "[MainWindow]: 删除视频窗口，当前数量：" << currentWidetCount;
 }
@@ -433,9 +694,11 @@ void MainWindow::on_actionAdd_triggered()
     // 增加新的视频窗口
     BasicViewWidget* newWidget = new BasicViewWidget(this);
     newWidget->setObjectName(QString("Video%1").arg(currentWidetCount + 1));
+    registerViewWidget(newWidget);
     
     // 添加到向量
     m_vectorWidget.push_back(newWidget);
+    m_wallView->setViews(m_vectorWidget);
     
     // 添加到标签页
     ui->videoWidget->addTab(newWidget, QString("Video%1").arg(currentWidetCount + 1));
@@ -488,9 +751,12 @@ void MainWindow::on_actionSeparation_Current_Widget_triggered()
             this, &MainWindow::onDetachedWindowClosing);
     connect(detachedWindow, &DetachedWindow::returnToMainWindow,
             this, &MainWindow::onReturnToMainWindow);
+    connect(detachedWindow, &DetachedWindow::minimizedChanged,
+            this, &MainWindow::updateViewPriorities);
     
     // 显示分离窗口
     detachedWindow->show();
+    updateViewPriorities();
     
     // 切换到下一个或上一个标签页
     int newIndex = -1;
@@ -522,6 +788,7 @@ void MainWindow::onDetachedWindowClosing(DetachedWindow *window)
         m_vectorWidget.remove(index);
         currentWidetCount--;
         m_reader->setViewCount(currentWidetCount);
+        m_wallView->setViews(m_vectorWidget);
     }
 }
 
@@ -549,6 +816,41 @@ void MainWindow::onReturnToMainWindow(DetachedWindow *window)
     // 关闭分离窗口
     window->close();
     window->deleteLater();
+    
+    updateViewPriorities();
+}
+
+void MainWindow::updateViewPriorities()
+{
+    const bool mainMinimized = isMinimized();
+    QWidget *currentTab = ui->videoWidget->currentWidget();
+    
+    for (BasicViewWidget *widget : m_vectorWidget) {
+        if (!widget || !widget->m_processor) {
+            continue;
+        }
+        
+        // 视频墙打开时所有视图都可见；分离窗口未最小化即可见；标签页中的视图只有当前页可见
+        bool visible;
+        if (m_wallView && m_wallView->isShowing()) {
+            visible = true;
+        } else if (DetachedWindow *window = m_detachedWindows.value(widget, nullptr)) {
+            visible = window->isVisible() && !window->isMinimized();
+        } else {
+            visible = !mainMinimized && widget == currentTab;
+        }
+        
+        widget->m_processor->setPriority(visible ? ViewPriority::Foreground : m_hiddenViewPriority);
+    }
+}
+
+void MainWindow::changeEvent(QEvent *event)
+{
+    // 主窗口最小化时标签页中的视图全部降级
+    if (event->type() == QEvent::WindowStateChange && ui->videoWidget) {
+        updateViewPriorities();
+    }
+    QMainWindow::changeEvent(event);
 }
 
 void MainWindow::dragEnterEvent(QDragEnterEvent *event)
@@ -976,6 +1278,37 @@ void MainWindow::performVideoExport(const QStringList &sources, const QString &e
     progressDialog->accept();
 }
 
+// 列表中与该图像同目录的图像，按文件名自然顺序组成图像序列
+QStringList MainWindow::imageSequenceFor(const QString &imagePath) const
+{
+    const QString dir = QFileInfo(imagePath).absolutePath();
+    QStringList images;
+    for (int i = 0; i < ui->V_ListWidget->count(); i++) {
+        const QString filePath = ui->V_ListWidget->item(i)->text();
+        if (ImageSequenceSource::isImageFile(filePath) && QFileInfo(filePath).absolutePath() == dir) {
+            images << filePath;
+        }
+    }
+    
+    QCollator collator;
+    collator.setNumericMode(true);
+    std::sort(images.begin(), images.end(), collator);
+    return images;
+}
+
+// 列表中的全部视频文件（按列表顺序），用于连续播放
+QStringList MainWindow::videoPlaylist() const
+{
+    QStringList videos;
+    for (int i = 0; i < ui->V_ListWidget->count(); i++) {
+        const QString filePath = ui->V_ListWidget->item(i)->text();
+        if (isVideoFile(filePath)) {
+            videos << filePath;
+        }
+    }
+    return videos;
+}
+
 // 检查文件是否是视频格式的辅助函数
 bool MainWindow::isVideoFile(const QString &filePath) const
 {
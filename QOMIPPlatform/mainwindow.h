@@ -10,7 +10,11 @@
 #include <QThread>
 #include <QMap>
 #include <QListWidget>
+#include <QSlider>
+#include <QLabel>
 #include "Reader.h"
+#include "framecreditpool.h"
+#include "decodeservice.h"
 #include "basicviewwidget.h"
 #include "cameramanager.h"
 #include "CustomerAlg/mobilenetssdconfigdialog.h"
@@ -20,6 +24,7 @@
 #include "videoexporter.h"
 
 class DetachedWindow;
+class WallView;
 struct WidgetExportConfig;
 
 QT_BEGIN_NAMESPACE
@@ -38,18 +43,25 @@ public:
     
 private slots:
     void on_playButton_clicked();
-    void on_Reader_FrameReady(const cv::Mat &frame);
+    void on_Reader_FrameReady(const SharedFrame &frame);
     void onProcessingFinished(const QString &message);
     void on_actionDelete_Current_Widget_triggered();
     void on_actionAdd_triggered();
     void on_actionSeparation_Current_Widget_triggered();
     void onDetachedWindowClosing(DetachedWindow *window);
     void onReturnToMainWindow(DetachedWindow *window);
+    void updateViewPriorities();
+    void onViewSourceRequested(BasicViewWidget *view, const SourceSpec &source);
     void onCameraListItemClicked(QListWidgetItem *item);
     void onCamerasUpdated(const QList<CameraManager::CameraInfo>& cameras);
     void refreshCameras();
     void on_actionImport_Algorithm_Ai_triggered();
     void on_actionCurrent_Algorithm_triggered();
+    void on_actionMax_Throughput_toggled(bool checked);
+    void on_actionPlaylist_Mode_toggled(bool checked);
+    void on_actionVideo_Wall_toggled(bool checked);
+    void onPlaylistIndexChanged(int index, const QString &path);
+    void onReaderPositionChanged(qint64 timestampMs, qint64 durationMs);
     
     void exportCurrentVideo();
     void exportAllVideos();
@@ -58,11 +70,19 @@ private:
     Ui::MainWindow *ui;
     QThread *m_readerThread;    // 视频读取线程
     Reader *m_reader;           // 视频读取工作对象
+    FrameCreditPool *m_creditPool;  // 各视图处理器的信用池（读取端背压）
+    DecodeService *m_decodeService; // 绑定了独立输入源的视图由解码服务供帧
+    ViewPriority m_hiddenViewPriority;  // 不可见视图的调度优先级（后台降频或暂停）
     QVector<BasicViewWidget*> m_vectorWidget;  // 视图窗口列表
     int currentWidetCount;      // 当前视图窗口数量
     QMap<BasicViewWidget*, DetachedWindow*> m_detachedWindows;  // 分离窗口映射
+    WallView *m_wallView = nullptr;   // 视频墙：所有视图合成到一幅画布
     CameraManager *m_cameraManager;  // 摄像头管理器
     QListWidget *m_cameraListWidget;  // 摄像头列表控件
+    QSlider *m_seekSlider;            // 播放位置（毫秒），拖动时只显示关键帧
+    QLabel *m_positionLabel;          // 播放位置/时长
+    bool m_resumeAfterScrub = false;  // 拖动结束后是否恢复播放
+    bool m_playlistMode = false;      // 视频列表连续播放
     
     // 算法配置相关
     MobileNetSSDConfigDialog::MobileNetSSDConfig m_mobilenetConfig;  // MobileNet SSD配置
@@ -71,6 +91,10 @@ private:
     
     void initAll();                    // 初始化界面和组件
     void initCameraUI();               // 初始化摄像头UI
+    void initSeekBar();                // 初始化播放位置条
+    void updatePositionLabel(qint64 timestampMs, qint64 durationMs);
+    void appendPlaybackStats();        // 位置标签附加播放节奏统计（丢帧、延迟）
+    void registerViewWidget(BasicViewWidget *widget);  // 注册新视图：信用池和输入源切换
     void loadMobileNetSSDConfig();     // 加载MobileNet SSD配置
     void saveMobileNetSSDConfig();     // 保存MobileNet SSD配置
     
@@ -79,8 +103,11 @@ private:
     QString getCurrentVideoSource() const;          // 获取当前视频源
     void performVideoExport(const QStringList &sources, const QString &exportDir, bool currentOnly = false);
     bool isVideoFile(const QString &filePath) const;  // 检查是否为视频文件
+    QStringList imageSequenceFor(const QString &imagePath) const;  // 列表中与该图像同目录的图像序列
+    QStringList videoPlaylist() const;  // 列表中的全部视频文件（按列表顺序）
     
 protected:
+    void changeEvent(QEvent *event) override;
     void dragEnterEvent(QDragEnterEvent *event) override;
     void dropEvent(QDropEvent *event) override;
     void dragLeaveEvent(QDragLeaveEvent *event) override;
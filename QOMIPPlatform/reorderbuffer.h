@@ -0,0 +1,58 @@
+#pragma once
+
+#include <QtGlobal>
+#include <map>
+#include <utility>
+#include <vector>
+
+/**
+ * @class ReorderBuffer
+ * @brief 按票号恢复顺序的重排缓冲区
+ *
+ * 多帧并行处理时结果完成的顺序不确定。每帧分发时领取一个递增票号，
+ * 完成后按票号放入缓冲区，takeReady() 只返回从下一个期望票号开始连续的结果。
+ * 非线程安全，由调用方加锁。
+ */
+template <typename T>
+class ReorderBuffer {
+public:
+    /**
+     * @brief 领取下一个票号
+     */
+    quint64 nextTicket() { return m_issued++; }
+
+    /**
+     * @brief 放入某个票号的结果（处理失败的帧也必须放入，以免阻塞后续帧）
+     */
+    void insert(quint64 ticket, T value)
+    {
+        m_pending.emplace(ticket, std::move(value));
+    }
+
+    /**
+     * @brief 取出所有已按顺序就绪的结果
+     */
+    std::vector<T> takeReady()
+    {
+        std::vector<T> ready;
+        auto it = m_pending.begin();
+        while (it != m_pending.end() && it->first == m_expected) {
+            ready.push_back(std::move(it->second));
+            it = m_pending.erase(it);
+            ++m_expected;
+        }
+        return ready;
+    }
+
+    int pendingCount() const { return static_cast<int>(m_pending.size()); }
+
+    /**
+     * @brief 已发出但尚未取出的票号数量
+     */
+    quint64 outstanding() const { return m_issued - m_expected; }
+
+private:
+    std::map<quint64, T> m_pending;
+    quint64 m_issued = 0;       // 下一个要发放的票号
+    quint64 m_expected = 0;     // 下一个要输出的票号
+};
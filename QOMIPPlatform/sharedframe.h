@@ -0,0 +1,182 @@
+#pragma once
+
+#include <QMetaType>
+#include <QtGlobal>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+
+/**
+ * @class SharedFrame
+ * @brief 引用计数的不可变帧句柄
+ *
+ * 一帧解码结果只分配一次像素内存，拷贝 SharedFrame 只增加引用计数，
+ * 因此可以零拷贝地分发给任意多个处理管线。像素通过 image() 以只读方式访问，
+ * 任何阶段都不得原地修改；需要产生新像素的阶段应分配新的 cv::Mat，
+ * 再用 derive() 包装成继承序号和时间戳的新帧。
+ *
+ * 解码器可以直接交出平面 YUV（I420/NV12）：Y 平面通过 luma() 零拷贝地作为灰度图使用，
+ * 只有需要彩色的阶段调用 image() 时才转换为 BGR，且每帧只转换一次。
+ */
+class SharedFrame {
+public:
+    /**
+     * @brief 像素格式
+     */
+    enum class PixelFormat {
+        BGR,    ///< 普通 cv::Mat（BGR、灰度等）
+        I420,   ///< 单通道 (h*3/2) x w 缓冲：Y 平面后接 U、V 平面
+        NV12    ///< 单通道 (h*3/2) x w 缓冲：Y 平面后接交错的 UV 平面
+    };
+
+    SharedFrame() = default;
+
+    /**
+     * @param image 帧像素（调用方之后不得再写入该缓冲区）
+     * @param sequence 帧序号（同一输入源内单调递增）
+     * @param timestampMs 帧时间戳(毫秒)
+     */
+    SharedFrame(const cv::Mat& image, quint64 sequence, qint64 timestampMs)
+        : d(std::make_shared<const Data>(image, PixelFormat::BGR, sequence, timestampMs, -1)) {}
+
+    /**
+     * @param pixels 帧像素；YUV 格式时为整个平面缓冲
+     * @param format pixels 的像素格式
+     * @param captureTimeUs 采集时刻（monotonicUs() 时钟），未知时为-1
+     */
+    SharedFrame(const cv::Mat& pixels, PixelFormat format, quint64 sequence, qint64 timestampMs,
+                qint64 captureTimeUs = -1)
+        : d(std::make_shared<const Data>(pixels, format, sequence, timestampMs, captureTimeUs)) {}
+
+    bool isNull() const { return !d; }
+    bool empty() const { return !d || d->pixels.empty(); }
+
+    PixelFormat format() const { return d ? d->format : PixelFormat::BGR; }
+
+    /**
+     * @brief 是否带有解码器原生的亮度平面（luma() 不需要颜色转换）
+     */
+    bool hasNativeLuma() const { return d && d->format != PixelFormat::BGR; }
+
+    /**
+     * @brief 图像尺寸（YUV 帧为 Y 平面尺寸）
+     */
+    cv::Size size() const { return d ? d->size : cv::Size(); }
+
+    /**
+     * @brief 只读像素视图（不拷贝）；YUV 帧第一次调用时转换为 BGR
+     */
+    const cv::Mat& image() const
+    {
+        if (!d) {
+            return emptyImage();
+        }
+        if (d->format == PixelFormat::BGR) {
+            return d->pixels;
+        }
+        std::call_once(d->convertOnce, [data = d.get()]() {
+            cv::cvtColor(data->pixels, data->converted,
+                         data->format == PixelFormat::NV12 ? cv::COLOR_YUV2BGR_NV12
+                                                           : cv::COLOR_YUV2BGR_I420);
+        });
+        return d->converted;
+    }
+
+    /**
+     * @brief 只读灰度视图
+     *
+     * YUV 帧直接返回 Y 平面（零拷贝）；BGR 帧第一次调用时转换，
+     * 结果随帧共享，多个视图不会重复转换。
+     */
+    const cv::Mat& luma() const
+    {
+        if (!d) {
+            return emptyImage();
+        }
+        if (d->format != PixelFormat::BGR || d->pixels.channels() == 1) {
+            return d->luma;
+        }
+        std::call_once(d->convertOnce, [data = d.get()]() {
+            cv::cvtColor(data->pixels, data->converted,
+                         data->pixels.channels() == 4 ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+        });
+        return d->converted;
+    }
+
+    quint64 sequence() const { return d ? d->sequence : 0; }
+    qint64 timestampMs() const { return d ? d->timestampMs : 0; }
+
+    /**
+     * @brief 采集时刻（monotonicUs() 时钟，微秒），只有实时源的帧带有，其它为-1
+     */
+    qint64 captureTimeUs() const { return d ? d->captureTimeUs : -1; }
+
+    /**
+     * @brief 进程内单调时钟(微秒)，用于计算采集到显示的延迟
+     */
+    static qint64 monotonicUs()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /**
+     * @brief 用新像素创建一帧，继承本帧的序号、时间戳和采集时刻
+     *
+     * 若 image 与本帧共享同一缓冲区（阶段直接返回了输入），则直接返回本帧，不新建句柄。
+     */
+    SharedFrame derive(const cv::Mat& image) const
+    {
+        if (d && d->format == PixelFormat::BGR && image.data == d->pixels.data
+            && image.size == d->pixels.size && image.type() == d->pixels.type()) {
+            return *this;
+        }
+        return SharedFrame(image, PixelFormat::BGR, sequence(), timestampMs(), captureTimeUs());
+    }
+
+    /**
+     * @brief 当前共享此帧的句柄数量（调试用）
+     */
+    long useCount() const { return d ? d.use_count() : 0; }
+
+private:
+    struct Data {
+        Data(const cv::Mat& pixels, PixelFormat format, quint64 sequence, qint64 timestampMs,
+             qint64 captureTimeUs)
+            : pixels(pixels), format(format), sequence(sequence), timestampMs(timestampMs)
+            , captureTimeUs(captureTimeUs)
+        {
+            if (format == PixelFormat::BGR) {
+                size = pixels.size();
+                if (pixels.channels() == 1) {
+                    luma = pixels;
+                }
+            } else {
+                // Y 平面是缓冲的前 2/3 行
+                size = cv::Size(pixels.cols, pixels.rows * 2 / 3);
+                luma = pixels.rowRange(0, size.height);
+            }
+        }
+
+        cv::Mat pixels;                     // 原始像素
+        PixelFormat format;
+        quint64 sequence;
+        qint64 timestampMs;
+        qint64 captureTimeUs;
+        cv::Size size;
+        cv::Mat luma;                       // 零拷贝的灰度视图（YUV 帧或单通道帧）
+        mutable std::once_flag convertOnce; // 保护 converted 的惰性转换
+        mutable cv::Mat converted;          // YUV 帧的 BGR 结果，或 BGR 帧的灰度结果
+    };
+
+    static const cv::Mat& emptyImage()
+    {
+        static const cv::Mat empty;
+        return empty;
+    }
+
+    std::shared_ptr<const Data> d;
+};
+
+Q_DECLARE_METATYPE(SharedFrame)
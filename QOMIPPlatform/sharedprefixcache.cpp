@@ -0,0 +1,146 @@
+#include "sharedprefixcache.h"
+#include <QByteArray>
+#include <QDataStream>
+#include <QIODevice>
+
+namespace {
+// 序号回退超过该值视为切换了输入源（多帧并行时正常的乱序远小于此）
+const quint64 kSourceResetGap = 256;
+}
+
+SharedPrefixCache& SharedPrefixCache::instance()
+{
+    static SharedPrefixCache cache;
+    return cache;
+}
+
+quint64 SharedPrefixCache::chainSignature(quint64 previous, int algorithmId, const QVariantMap& params)
+{
+    // QVariantMap按键排序，序列化结果对相同参数是确定的
+    QByteArray bytes;
+    QDataStream stream(&bytes, QIODevice::WriteOnly);
+    stream << previous << algorithmId << params;
+
+    // 两个不同种子的哈希拼成64位，降低不同前缀的碰撞概率
+    const quint64 high = static_cast<quint32>(qHash(bytes, 0x9e3779b9u));
+    const quint64 low = static_cast<quint32>(qHash(bytes, 0x85ebca6bu));
+    return (high << 32) | low;
+}
+
+void SharedPrefixCache::retain(const void *owner, quint64 signature)
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_owners[signature][owner];
+}
+
+void SharedPrefixCache::release(const void *owner, quint64 signature)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_owners.find(signature);
+    if (it == m_owners.end()) {
+        return;
+    }
+
+    auto ownerIt = it->find(owner);
+    if (ownerIt != it->end() && --ownerIt.value() <= 0) {
+        it->erase(ownerIt);
+    }
+    if (it->isEmpty()) {
+        m_owners.erase(it);
+    }
+}
+
+bool SharedPrefixCache::isShared(quint64 signature) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_owners.constFind(signature);
+    return it != m_owners.constEnd() && it->size() >= 2;
+}
+
+bool SharedPrefixCache::acquire(const cv::Mat& input, quint64 sequence, quint64 signature, cv::Mat& result,
+                                cv::Mat* display)
+{
+    const Key key{input.data, sequence, signature};
+
+    QMutexLocker locker(&m_mutex);
+    while (true) {
+        auto it = m_entries.find(key);
+        if (it == m_entries.end()) {
+            // 无人计算过：认领
+            Entry entry;
+            entry.input = input;
+            m_entries.emplace(key, std::move(entry));
+            // 序号前进或大幅回退（切换了输入源）时淘汰窗口外的帧
+            if (sequence > m_latestSequence || sequence + kSourceResetGap <= m_latestSequence) {
+                m_latestSequence = sequence;
+                evictLocked();
+            }
+            return false;
+        }
+
+        if (it->second.ready) {
+            result = it->second.result;
+            if (display) {
+                *display = it->second.display;
+            }
+            return true;
+        }
+
+        // 其它视图正在计算，等待其发布（认领者正在执行，不会无限等待）
+        m_published.wait(&m_mutex);
+    }
+}
+
+void SharedPrefixCache::publish(const cv::Mat& input, quint64 sequence, quint64 signature, const cv::Mat& result,
+                                const cv::Mat& display)
+{
+    const Key key{input.data, sequence, signature};
+
+    QMutexLocker locker(&m_mutex);
+    if (result.empty() && display.empty()) {
+        // 放弃认领，等待者会重新认领并自行计算
+        m_entries.erase(key);
+    } else {
+        Entry& entry = m_entries[key];
+        entry.input = input;
+        entry.result = result;
+        entry.display = display;
+        entry.ready = true;
+    }
+    m_published.wakeAll();
+}
+
+void SharedPrefixCache::setWindow(int frames)
+{
+    QMutexLocker locker(&m_mutex);
+    m_window = qMax(1, frames);
+    evictLocked();
+}
+
+int SharedPrefixCache::window() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_window;
+}
+
+void SharedPrefixCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    // 正在计算的条目保留，认领者稍后会发布
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        it = it->second.ready ? m_entries.erase(it) : std::next(it);
+    }
+}
+
+void SharedPrefixCache::evictLocked()
+{
+    const quint64 window = static_cast<quint64>(m_window);
+    const quint64 oldest = m_latestSequence >= window ? m_latestSequence - window + 1 : 0;
+
+    // 淘汰窗口之外的帧；正在计算的条目有等待者，发布后再随下一帧淘汰
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        const quint64 sequence = it->first.sequence;
+        const bool outside = sequence < oldest || sequence > m_latestSequence;
+        it = (outside && it->second.ready) ? m_entries.erase(it) : std::next(it);
+    }
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <QHash>
+#include <QVariantMap>
+#include <QtGlobal>
+#include <map>
+#include <opencv2/opencv.hpp>
+
+/**
+ * @class SharedPrefixCache
+ * @brief 跨视图共享算法链公共前缀的中间结果
+ *
+ * 多个视图的算法链以相同的无状态阶段开头（算法ID与参数都相同）时，
+ * 对同一输入帧只计算一次该前缀，其余视图直接取用结果。
+ * 前缀用累积签名标识；只有被两个以上视图登记的签名才会缓存，单视图没有额外开销。
+ *
+ * 第一个需要某前缀结果的视图认领并计算，其它视图等待其发布；
+ * 计算失败时放弃认领，等待者各自重新计算。缓存只保留最近若干帧的结果，
+ * 条目同时持有输入帧的引用，保证按缓冲区地址区分帧不会误命中。
+ */
+class SharedPrefixCache {
+public:
+    static SharedPrefixCache& instance();
+
+    /**
+     * @brief 计算第 n 级前缀的累积签名
+     * @param previous 前 n-1 级的签名（第一级传0）
+     */
+    static quint64 chainSignature(quint64 previous, int algorithmId, const QVariantMap& params);
+
+    /**
+     * @brief 登记/注销某个视图使用的前缀签名（同一视图可重复登记）
+     */
+    void retain(const void *owner, quint64 signature);
+    void release(const void *owner, quint64 signature);
+
+    /**
+     * @brief 签名是否被至少两个视图使用
+     */
+    bool isShared(quint64 signature) const;
+
+    /**
+     * @brief 查找前缀结果
+     * @param display 可选，输出与结果一同发布的全分辨率图像
+     * @return 命中（或等到其它视图发布）时返回true并输出结果；
+     *         返回false表示调用方已认领，计算后必须调用 publish()
+     */
+    bool acquire(const cv::Mat& input, quint64 sequence, quint64 signature, cv::Mat& result,
+                 cv::Mat* display = nullptr);
+
+    /**
+     * @brief 发布认领的前缀结果；result 与 display 都为空表示放弃认领
+     * @param display 工作分辨率下与结果对应的全分辨率图像（可为空）
+     */
+    void publish(const cv::Mat& input, quint64 sequence, quint64 signature, const cv::Mat& result,
+                 const cv::Mat& display = cv::Mat());
+
+    /**
+     * @brief 保留结果的帧数（按帧序号），默认3帧
+     */
+    void setWindow(int frames);
+    int window() const;
+
+    void clear();
+
+private:
+    SharedPrefixCache() = default;
+    SharedPrefixCache(const SharedPrefixCache&) = delete;
+    SharedPrefixCache& operator=(const SharedPrefixCache&) = delete;
+
+    struct Key {
+        const uchar *data;
+        quint64 sequence;
+        quint64 signature;
+
+        bool operator<(const Key& other) const
+        {
+            if (sequence != other.sequence) return sequence < other.sequence;
+            if (data != other.data) return data < other.data;
+            return signature < other.signature;
+        }
+    };
+
+    struct Entry {
+        cv::Mat input;          // 持有输入帧，防止缓冲区地址被复用
+        cv::Mat result;
+        cv::Mat display;        // 工作分辨率下对应的全分辨率图像
+        bool ready = false;     // false表示已被认领、正在计算
+    };
+
+    void evictLocked();
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_published;                         // 有结果发布或认领被放弃时唤醒
+    std::map<Key, Entry> m_entries;                     // 按帧序号排序，便于淘汰旧帧
+    QHash<quint64, QHash<const void*, int>> m_owners;   // 签名 -> 使用它的视图及登记次数
+    quint64 m_latestSequence = 0;
+    int m_window = 3;
+};
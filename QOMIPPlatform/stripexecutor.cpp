@@ -0,0 +1,62 @@
+#include "stripexecutor.h"
+#include "taskscheduler.h"
+#include <vector>
+
+namespace {
+// 小于该像素数的帧整帧处理，分条调度的开销抵不过并行收益
+const int kMinPixels = 1280 * 720;
+
+// 每个横条至少的有效行数
+const int kMinStripRows = 64;
+
+// 有效行数至少是重叠行数的倍数，否则重复计算过多
+const int kHaloFactor = 4;
+}
+
+int StripExecutor::stripCount(const cv::Mat& image, int radius)
+{
+    if (radius < 0 || image.empty() || image.total() < static_cast<size_t>(kMinPixels)) {
+        return 1;
+    }
+
+    // 调用线程也参与执行，因此可用线程数为工作线程数+1
+    const int workers = TaskScheduler::instance().workerCount();
+    if (workers == 0) {
+        return 1;
+    }
+
+    const int minRows = qMax(kMinStripRows, radius * 2 * kHaloFactor);
+    return qBound(1, image.rows / minRows, workers + 1);
+}
+
+bool StripExecutor::shouldSplit(const cv::Mat& image, int radius)
+{
+    return stripCount(image, radius) > 1;
+}
+
+cv::Mat StripExecutor::run(const cv::Mat& input, int radius, const Body& body)
+{
+    const int count = stripCount(input, radius);
+    if (count <= 1) {
+        return body(input);
+    }
+
+    std::vector<cv::Mat> results(count);
+    TaskScheduler::instance().parallelFor(count, [&](int i) {
+        const int top = i * input.rows / count;
+        const int bottom = (i + 1) * input.rows / count;
+        const int haloTop = qMin(radius, top);
+        const int haloBottom = qMin(radius, input.rows - bottom);
+
+        // ROI 不拷贝像素，重叠行直接读取相邻条带的真实像素
+        const cv::Mat strip = input.rowRange(top - haloTop, bottom + haloBottom);
+        const cv::Mat output = body(strip);
+        CV_Assert(output.rows == strip.rows && output.cols == strip.cols);
+
+        results[i] = output.rowRange(haloTop, output.rows - haloBottom);
+    });
+
+    cv::Mat stitched;
+    cv::vconcat(results, stitched);
+    return stitched;
+}
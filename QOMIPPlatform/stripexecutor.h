@@ -0,0 +1,33 @@
+#pragma once
+
+#include <functional>
+#include <opencv2/opencv.hpp>
+
+/**
+ * @class StripExecutor
+ * @brief 把一帧切成带重叠边（halo）的横条，在共享线程池中并行处理后拼接
+ *
+ * 适用于输出像素只依赖邻域内输入像素的运算。每个横条向上下各多取 radius 行，
+ * 处理后裁掉多取的部分，因此拼接结果与整帧处理完全一致。
+ * 帧太小、重叠边相对条带过大或线程池未运行时不分条。
+ */
+class StripExecutor {
+public:
+    using Body = std::function<cv::Mat(const cv::Mat&)>;
+
+    /**
+     * @brief 判断按给定半径分条是否划算
+     */
+    static bool shouldSplit(const cv::Mat& image, int radius);
+
+    /**
+     * @brief 分条执行 body 并拼接结果
+     * @param input 输入帧
+     * @param radius 邻域半径（行数），body 内多个运算串联时为各半径之和
+     * @param body 处理函数，可被多个线程同时调用，输出行数必须与输入相同
+     */
+    static cv::Mat run(const cv::Mat& input, int radius, const Body& body);
+
+private:
+    static int stripCount(const cv::Mat& image, int radius);
+};
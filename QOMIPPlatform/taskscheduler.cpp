@@ -0,0 +1,309 @@
+#include "taskscheduler.h"
+#include <QDebug>
+#include <exception>
+#include <opencv2/core.hpp>
+
+#if defined(__has_include)
+#  if __has_include(<opencv2/core/parallel/parallel_backend.hpp>)
+#    include <opencv2/core/parallel/parallel_backend.hpp>
+#    define QOMIP_HAS_CV_PARALLEL_BACKEND 1
+#  endif
+#endif
+
+namespace {
+
+// 当前线程的工作线程编号
+thread_local int t_workerIndex = -1;
+
+// parallelFor 的共享状态：调用线程与辅助任务从同一个计数器领取下标
+struct ParallelForState {
+    ParallelForState(int n, const std::function<void(int)> *f) : count(n), body(f) {}
+
+    const int count;
+    const std::function<void(int)> *body;   // 只在 next < count 时访问，调用方保证其生命周期
+    std::atomic<int> next{0};
+    std::atomic<int> done{0};
+    QMutex mutex;
+    QWaitCondition finished;
+    std::exception_ptr error;
+
+    void run()
+    {
+        int i;
+        while ((i = next.fetch_add(1, std::memory_order_relaxed)) < count) {
+            try {
+                (*body)(i);
+            } catch (...) {
+                QMutexLocker locker(&mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+            if (done.fetch_add(1, std::memory_order_acq_rel) + 1 == count) {
+                QMutexLocker locker(&mutex);
+                finished.wakeAll();
+            }
+        }
+    }
+
+    void wait()
+    {
+        QMutexLocker locker(&mutex);
+        while (done.load(std::memory_order_acquire) < count) {
+            finished.wait(&mutex);
+        }
+    }
+};
+
+#ifdef QOMIP_HAS_CV_PARALLEL_BACKEND
+// 把OpenCV的parallel_for_转发到共享线程池
+class SchedulerParallelBackend : public cv::parallel::ParallelForAPI {
+public:
+    explicit SchedulerParallelBackend(TaskScheduler &scheduler) : m_scheduler(scheduler) {}
+
+    void parallel_for(int tasks, FN_parallel_for_body_cb_t body_callback, void *callback_data) override
+    {
+        m_scheduler.parallelFor(tasks, [body_callback, callback_data](int i) {
+            body_callback(i, i + 1, callback_data);
+        });
+    }
+
+    int getThreadNum() const override
+    {
+        // 非工作线程（如GUI线程）记为0，工作线程从1开始
+        return TaskScheduler::currentWorkerIndex() + 1;
+    }
+
+    int getNumThreads() const override
+    {
+        return m_scheduler.workerCount() + 1;
+    }
+
+    int setNumThreads(int nThreads) override
+    {
+        // 线程数由TaskScheduler统一配置，这里只返回当前值
+        Q_UNUSED(nThreads);
+        return getNumThreads();
+    }
+
+    const char *getName() const override
+    {
+        return "qomip-task-scheduler";
+    }
+
+private:
+    TaskScheduler &m_scheduler;
+};
+#endif
+
+} // namespace
+
+TaskScheduler& TaskScheduler::instance()
+{
+    static TaskScheduler scheduler;
+    return scheduler;
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    shutdown();
+}
+
+void TaskScheduler::start(int workerCount)
+{
+    QMutexLocker locker(&m_controlMutex);
+    if (m_running.load()) {
+        return;
+    }
+
+    if (workerCount <= 0) {
+        workerCount = qMax(1, QThread::idealThreadCount());
+    }
+
+    m_stopping = false;
+    m_workers.clear();
+    for (int i = 0; i < workerCount; ++i) {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+
+    // 先标记为运行，保证工作线程启动前提交的任务也进入队列
+    m_running.store(true, std::memory_order_release);
+
+    for (int i = 0; i < workerCount; ++i) {
+        QThread *thread = QThread::create([this, i]() { workerLoop(i); });
+        thread->setObjectName(QString("TaskWorker-%1").arg(i));
+        m_workers[i]->thread = thread;
+        thread->start();
+    }
+
+    qDebug() << "[TaskScheduler] 启动工作线程数:" << workerCount;
+}
+
+void TaskScheduler::shutdown()
+{
+    QMutexLocker locker(&m_controlMutex);
+    if (!m_running.load()) {
+        return;
+    }
+
+    // 工作线程会先把队列中剩余的任务执行完再退出
+    {
+        QMutexLocker sleepLocker(&m_sleepMutex);
+        m_stopping = true;
+        m_wakeup.wakeAll();
+    }
+
+    for (auto &worker : m_workers) {
+        worker->thread->wait();
+        delete worker->thread;
+        worker->thread = nullptr;
+    }
+
+    m_running.store(false, std::memory_order_release);
+    m_workers.clear();
+}
+
+int TaskScheduler::workerCount() const
+{
+    return isRunning() ? static_cast<int>(m_workers.size()) : 0;
+}
+
+int TaskScheduler::currentWorkerIndex()
+{
+    return t_workerIndex;
+}
+
+void TaskScheduler::submit(Task task)
+{
+    if (!task) {
+        return;
+    }
+
+    if (!isRunning() || m_stopping.load(std::memory_order_acquire)) {
+        // 线程池未运行（启动前或退出后），直接同步执行
+        task();
+        return;
+    }
+
+    // 工作线程提交的任务放入自己的队列，外部提交轮询分配
+    int index = t_workerIndex;
+    if (index < 0 || index >= static_cast<int>(m_workers.size())) {
+        index = static_cast<int>(m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_workers.size());
+    }
+
+    {
+        QMutexLocker locker(&m_workers[index]->mutex);
+        m_workers[index]->deque.push_back(std::move(task));
+    }
+
+    m_pending.fetch_add(1, std::memory_order_release);
+
+    QMutexLocker sleepLocker(&m_sleepMutex);
+    m_wakeup.wakeOne();
+}
+
+void TaskScheduler::parallelFor(int count, const std::function<void(int)>& body)
+{
+    if (count <= 0) {
+        return;
+    }
+
+    const int workers = workerCount();
+    if (count == 1 || workers == 0) {
+        for (int i = 0; i < count; ++i) {
+            body(i);
+        }
+        return;
+    }
+
+    auto state = std::make_shared<ParallelForState>(count, &body);
+
+    // 辅助任务数不超过剩余下标数；晚到的辅助任务领取不到下标会直接返回
+    const int helpers = qMin(count - 1, workers);
+    for (int h = 0; h < helpers; ++h) {
+        submit([state]() { state->run(); });
+    }
+
+    // 调用线程同样参与执行，然后等待已被领取的下标完成
+    state->run();
+    state->wait();
+
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
+
+bool TaskScheduler::installOpenCVBackend()
+{
+#ifdef QOMIP_HAS_CV_PARALLEL_BACKEND
+    cv::parallel::setParallelForBackend(std::make_shared<SchedulerParallelBackend>(*this), false);
+    qDebug() << "[TaskScheduler] 已接管OpenCV parallel_for_";
+    return true;
+#else
+    qWarning() << "[TaskScheduler] 当前OpenCV版本不支持替换并行后端";
+    return false;
+#endif
+}
+
+bool TaskScheduler::popLocal(int index, Task &task)
+{
+    Worker &worker = *m_workers[index];
+    QMutexLocker locker(&worker.mutex);
+    if (worker.deque.empty()) {
+        return false;
+    }
+    // 本地队列后进先出，刚提交的任务数据更可能还在缓存中
+    task = std::move(worker.deque.back());
+    worker.deque.pop_back();
+    return true;
+}
+
+bool TaskScheduler::steal(int thief, Task &task)
+{
+    const int n = static_cast<int>(m_workers.size());
+    for (int offset = 1; offset < n; ++offset) {
+        Worker &victim = *m_workers[(thief + offset) % n];
+        QMutexLocker locker(&victim.mutex);
+        if (!victim.deque.empty()) {
+            // 从队首窃取最早提交的任务
+            task = std::move(victim.deque.front());
+            victim.deque.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void TaskScheduler::workerLoop(int index)
+{
+    t_workerIndex = index;
+
+    while (true) {
+        Task task;
+        if (popLocal(index, task) || steal(index, task)) {
+            m_pending.fetch_sub(1, std::memory_order_acq_rel);
+            try {
+                task();
+            } catch (const cv::Exception &e) {
+                qWarning() << "[TaskScheduler] OpenCV错误:" << e.what();
+            } catch (const std::exception &e) {
+                qWarning() << "[TaskScheduler] 任务异常:" << e.what();
+            } catch (...) {
+                qWarning() << "[TaskScheduler] 任务发生未知异常";
+            }
+            continue;
+        }
+
+        // 没有可执行的任务：停止时退出，否则休眠等待新任务
+        QMutexLocker sleepLocker(&m_sleepMutex);
+        if (m_pending.load(std::memory_order_acquire) > 0) {
+            continue;
+        }
+        if (m_stopping.load(std::memory_order_acquire)) {
+            break;
+        }
+        m_wakeup.wait(&m_sleepMutex);
+    }
+
+    t_workerIndex = -1;
+}
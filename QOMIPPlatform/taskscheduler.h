@@ -0,0 +1,89 @@
+#pragma once
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThread>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * @class TaskScheduler
+ * @brief 进程内共享的工作窃取线程池
+ *
+ * 所有视图的处理管线都以任务的形式提交到这里，线程数由配置决定，
+ * 与标签页数量无关。每个工作线程有自己的双端队列：本线程提交的任务从队尾
+ * 取出（缓存友好），空闲线程从其它线程的队首窃取任务。
+ * 同时可以注册为OpenCV的parallel_for_后端，避免OpenCV内部线程池与之叠加造成过量订阅。
+ */
+class TaskScheduler {
+public:
+    using Task = std::function<void()>;
+
+    // 获取单例实例
+    static TaskScheduler& instance();
+
+    /**
+     * @brief 启动工作线程
+     * @param workerCount 工作线程数，<=0 时使用 QThread::idealThreadCount()
+     */
+    void start(int workerCount = 0);
+
+    /**
+     * @brief 执行完已提交的任务后停止所有工作线程
+     */
+    void shutdown();
+
+    bool isRunning() const { return m_running.load(std::memory_order_acquire); }
+    int workerCount() const;
+
+    /**
+     * @brief 提交任务；线程池未运行时在调用线程中同步执行
+     */
+    void submit(Task task);
+
+    /**
+     * @brief 并行执行 body(0) ... body(count-1)，返回时全部执行完毕
+     *
+     * 调用线程也参与执行，因此在工作线程中嵌套调用不会死锁。
+     */
+    void parallelFor(int count, const std::function<void(int)>& body);
+
+    /**
+     * @brief 当前线程在池中的编号，非工作线程返回-1
+     */
+    static int currentWorkerIndex();
+
+    /**
+     * @brief 将本线程池注册为OpenCV的parallel_for_后端
+     * @return OpenCV版本不支持后端替换时返回false
+     */
+    bool installOpenCVBackend();
+
+private:
+    TaskScheduler() = default;
+    ~TaskScheduler();
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    struct Worker {
+        QMutex mutex;               // 保护deque
+        std::deque<Task> deque;     // 本地任务队列
+        QThread *thread = nullptr;
+    };
+
+    void workerLoop(int index);
+    bool popLocal(int index, Task &task);
+    bool steal(int thief, Task &task);
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    mutable QMutex m_controlMutex;          // 保护start/shutdown
+    QMutex m_sleepMutex;                    // 与m_wakeup配合使用
+    QWaitCondition m_wakeup;                // 有新任务或停止时唤醒工作线程
+    std::atomic<int> m_pending{0};          // 已提交但尚未被取走的任务数
+    std::atomic<bool> m_running{false};
+    std::atomic<bool> m_stopping{false};
+    std::atomic<unsigned> m_nextQueue{0};   // 外部提交的轮询目标
+};
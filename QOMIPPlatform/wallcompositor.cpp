@@ -0,0 +1,244 @@
+#include "wallcompositor.h"
+#include "displayconvert.h"
+#include "taskscheduler.h"
+#include <cmath>
+
+namespace {
+
+// 同时存在的画布：显示中一幅、等待显示一幅、正在合成一幅
+constexpr int kCanvasCount = 3;
+
+// 不透明黑色（预乘格式下与通道顺序无关）
+const cv::Scalar kBackground(0, 0, 0, 255);
+
+void releaseCanvas(void *info)
+{
+    delete static_cast<cv::Mat*>(info);
+}
+
+} // namespace
+
+WallCompositor::WallCompositor(Publisher publisher)
+    : m_publisher(std::move(publisher))
+{
+}
+
+void WallCompositor::setLayout(const QSize& canvasSize, int tileCount, int focus)
+{
+    const cv::Size size(qMax(0, canvasSize.width()), qMax(0, canvasSize.height()));
+    std::vector<cv::Mat> sources;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (size == m_size && tileCount == m_tileCount && focus == m_focus) {
+            return;
+        }
+        if (size != m_size) {
+            // 画布只在尺寸变化时重新分配；仍被显示的旧画布由 QImage 持有，之后自然释放
+            m_canvases.assign(kCanvasCount, Canvas());
+            if (!size.empty()) {
+                for (Canvas& canvas : m_canvases) {
+                    canvas.pixels.create(size, CV_8UC4);
+                }
+            }
+        }
+        m_size = size;
+        m_tileCount = qMax(0, tileCount);
+        m_focus = focus >= 0 && focus < m_tileCount ? focus : -1;
+        ++m_layout;
+        if (static_cast<int>(m_sources.size()) != m_tileCount) {
+            // 视图增删后格子对应的视图变了
+            m_sources.assign(m_tileCount, cv::Mat());
+            m_ranges.clear();
+            for (int slot = 0; slot < m_tileCount; ++slot) {
+                m_ranges.push_back(std::make_shared<DisplayConvert::RangeTracker>());
+            }
+        }
+        m_tiles.assign(m_tileCount, Tile());
+        sources = m_sources;
+        m_dirty = true;     // 即使还没有结果，也要按新布局清空画布
+    }
+
+    // 按新布局在工作线程中重新缩放各视图最近的结果，暂停播放时画面也不会变空
+    for (int slot = 0; slot < static_cast<int>(sources.size()); ++slot) {
+        if (!sources[slot].empty()) {
+            TaskScheduler::instance().submit([self = shared_from_this(), slot, source = sources[slot]]() {
+                self->renderTile(slot, source, true);
+            });
+        }
+    }
+}
+
+cv::Rect WallCompositor::cellRectLocked(int slot) const
+{
+    if (slot < 0 || slot >= m_tileCount || m_size.empty()) {
+        return cv::Rect();
+    }
+    if (m_focus >= 0) {
+        return slot == m_focus ? cv::Rect(0, 0, m_size.width, m_size.height) : cv::Rect();
+    }
+    // 接近正方形的网格，按行排列
+    const int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(m_tileCount))));
+    const int rows = (m_tileCount + columns - 1) / columns;
+    const int column = slot % columns;
+    const int row = slot / columns;
+    const int x0 = m_size.width * column / columns;
+    const int x1 = m_size.width * (column + 1) / columns;
+    const int y0 = m_size.height * row / rows;
+    const int y1 = m_size.height * (row + 1) / rows;
+    return cv::Rect(x0, y0, x1 - x0, y1 - y0);
+}
+
+QRect WallCompositor::tileRect(int slot) const
+{
+    QMutexLocker locker(&m_mutex);
+    const cv::Rect cell = cellRectLocked(slot);
+    return QRect(cell.x, cell.y, cell.width, cell.height);
+}
+
+int WallCompositor::tileAt(const QPoint& canvasPos) const
+{
+    QMutexLocker locker(&m_mutex);
+    for (int slot = 0; slot < m_tileCount; ++slot) {
+        if (cellRectLocked(slot).contains(cv::Point(canvasPos.x(), canvasPos.y()))) {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+void WallCompositor::submit(int slot, const cv::Mat& result)
+{
+    if (result.empty()) {
+        return;
+    }
+    {
+        QMutexLocker locker(&m_mutex);
+        if (slot >= 0 && slot < static_cast<int>(m_sources.size())) {
+            m_sources[slot] = result;   // 只读共享，布局变化时重新缩放
+        }
+    }
+    renderTile(slot, result, false);
+}
+
+void WallCompositor::renderTile(int slot, const cv::Mat& result, bool onlyIfEmpty)
+{
+    cv::Rect cell;
+    quint64 layout = 0;
+    std::shared_ptr<DisplayConvert::RangeTracker> range;
+    {
+        QMutexLocker locker(&m_mutex);
+        cell = cellRectLocked(slot);
+        layout = m_layout;
+        if (!cell.empty()) {
+            range = m_ranges[slot];
+        }
+    }
+    if (cell.empty()) {
+        return;     // 该格子当前不显示
+    }
+
+    // 在处理线程中直接缩小到格子尺寸（保持宽高比居中），之后只拷贝格子大小的像素
+    const double fit = qMin(cell.width / static_cast<double>(result.cols),
+                            cell.height / static_cast<double>(result.rows));
+    const cv::Size size(qBound(1, qRound(result.cols * fit), cell.width),
+                        qBound(1, qRound(result.rows * fit), cell.height));
+    cv::Mat scaled;
+    cv::resize(result, scaled, size, 0.0, 0.0, fit < 1.0 ? cv::INTER_AREA : cv::INTER_LINEAR);
+    cv::Mat tile;
+    if (!DisplayConvert::convertForDisplay(scaled, tile, range.get())) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (layout != m_layout) {
+        return;     // 转换期间布局变了
+    }
+    Tile& entry = m_tiles[slot];
+    if (onlyIfEmpty && entry.generation != 0) {
+        return;     // 重新缩放期间已有更新的结果
+    }
+    entry.image = tile;
+    entry.rect = cv::Rect(cell.x + (cell.width - size.width) / 2,
+                          cell.y + (cell.height - size.height) / 2,
+                          size.width, size.height);
+    entry.generation = ++m_generation;
+    m_dirty = true;
+}
+
+void WallCompositor::requestComposite()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_dirty || m_compositing || m_size.empty() || !m_publisher) {
+        return;
+    }
+    m_compositing = true;
+    TaskScheduler::instance().submit([self = shared_from_this()]() {
+        self->composite();
+    });
+}
+
+void WallCompositor::composite()
+{
+    struct Update {
+        cv::Rect cell;
+        Tile tile;
+    };
+    cv::Mat pixels;
+    bool clear = false;
+    std::vector<Update> updates;
+    {
+        QMutexLocker locker(&m_mutex);
+        // 只写入没有被任何 QImage 引用的画布；都在使用时等下个显示周期
+        Canvas *canvas = nullptr;
+        for (Canvas& candidate : m_canvases) {
+            if (candidate.pixels.u && candidate.pixels.u->refcount == 1) {
+                canvas = &candidate;
+                break;
+            }
+        }
+        if (!canvas) {
+            m_compositing = false;
+            return;
+        }
+        m_dirty = false;
+
+        if (canvas->layout != m_layout) {
+            canvas->layout = m_layout;
+            canvas->generations.assign(m_tileCount, 0);
+            clear = true;
+        }
+        for (int slot = 0; slot < m_tileCount; ++slot) {
+            const Tile& tile = m_tiles[slot];
+            if (tile.generation > canvas->generations[slot]) {
+                canvas->generations[slot] = tile.generation;
+                updates.push_back({cellRectLocked(slot), tile});
+            }
+        }
+        pixels = canvas->pixels;    // 持有引用：合成期间不会被再次选中
+    }
+
+    // 锁外拷贝：格子结果不可变，新结果总是新的 Mat
+    if (clear) {
+        pixels.setTo(kBackground);
+    }
+    for (const Update& update : updates) {
+        if (!clear) {
+            pixels(update.cell).setTo(kBackground);     // 结果尺寸可能变化
+        }
+        update.tile.image.copyTo(pixels(update.tile.rect));
+    }
+
+    const QImage image(pixels.data, pixels.cols, pixels.rows, static_cast<int>(pixels.step),
+                       DisplayConvert::displayFormat(), releaseCanvas, new cv::Mat(pixels));
+    QMutexLocker locker(&m_mutex);
+    m_compositing = false;
+    if (m_publisher) {
+        m_publisher(image);
+    }
+}
+
+void WallCompositor::shutdown()
+{
+    QMutexLocker locker(&m_mutex);
+    m_publisher = nullptr;
+}
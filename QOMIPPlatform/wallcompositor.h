@@ -0,0 +1,110 @@
+#pragma once
+
+#include <QImage>
+#include <QMutex>
+#include <QRect>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "displayconvert.h"
+
+/**
+ * @class WallCompositor
+ * @brief 视频墙合成器：把多个视图的处理结果合成到一幅预分配的画布上
+ *
+ * 处理线程通过 submit() 交出结果，结果在处理线程中直接缩小到所在格子的尺寸并转换为
+ * DisplayConvert::displayFormat()，只保留每个格子最新的一块。GUI 线程每个显示周期调用一次
+ * requestComposite()，合成在调度器的工作线程中进行：只把上次写入该画布之后更新过的格子
+ * 拷贝进去，然后通过发布回调交出整幅画布，GUI 线程每次只绘制这一幅图像。
+ *
+ * 画布按控件的物理像素尺寸预分配几块轮流使用，QImage 只引用画布、不拷贝，
+ * 最后一个引用释放后画布才会被再次写入。
+ *
+ * 聚焦某个格子时，该视图的结果占据整幅画布，其余视图的结果直接丢弃。
+ */
+class WallCompositor : public std::enable_shared_from_this<WallCompositor> {
+public:
+    /**
+     * @brief 发布合成结果，在合成线程中调用，持有合成器的锁，只应投递事件
+     */
+    using Publisher = std::function<void(const QImage&)>;
+
+    explicit WallCompositor(Publisher publisher);
+
+    /**
+     * @brief 设置画布尺寸、格子数和聚焦的格子（GUI线程）
+     * @param canvasSize 画布尺寸（物理像素），为空时不合成，交来的结果直接丢弃
+     * @param tileCount 格子数，按接近正方形的网格排列
+     * @param focus 聚焦的格子，-1 表示显示网格
+     */
+    void setLayout(const QSize& canvasSize, int tileCount, int focus);
+
+    /**
+     * @brief 格子在画布中的区域，不显示的格子返回空区域
+     */
+    QRect tileRect(int slot) const;
+
+    /**
+     * @brief 画布坐标所在的格子，不在任何格子中时返回-1
+     */
+    int tileAt(const QPoint& canvasPos) const;
+
+    /**
+     * @brief 交出一个视图的处理结果（线程安全，在处理线程中调用）
+     */
+    void submit(int slot, const cv::Mat& result);
+
+    /**
+     * @brief 有更新的格子且上一次合成已完成时，安排一次合成（GUI线程，每个显示周期一次）
+     */
+    void requestComposite();
+
+    /**
+     * @brief 停止发布：返回后不会再调用发布回调
+     */
+    void shutdown();
+
+private:
+    struct Tile {
+        cv::Mat  image;             ///< 已缩小、已转换的最新结果
+        cv::Rect rect;              ///< image 在画布中的位置（格子内居中）
+        quint64  generation = 0;    ///< 每次更新加一，0 表示还没有结果
+    };
+
+    struct Canvas {
+        cv::Mat pixels;                     ///< 预分配的画布（CV_8UC4）
+        std::vector<quint64> generations;   ///< 画布中每个格子对应的结果版本
+        quint64 layout = 0;                 ///< 画布内容对应的布局版本
+    };
+
+    /**
+     * @brief 合成并发布一幅画布（调度器工作线程）
+     */
+    void composite();
+
+    /**
+     * @brief 把结果缩小到格子尺寸并转换，放入格子
+     * @param onlyIfEmpty 只在格子还没有结果时放入（布局变化后重新缩放旧结果）
+     */
+    void renderTile(int slot, const cv::Mat& result, bool onlyIfEmpty);
+
+    /**
+     * @brief 格子的区域（调用者持有锁）
+     */
+    cv::Rect cellRectLocked(int slot) const;
+
+    mutable QMutex m_mutex;
+    Publisher m_publisher;
+    cv::Size m_size;
+    int m_tileCount = 0;
+    int m_focus = -1;
+    quint64 m_layout = 0;           ///< 布局版本，布局变化后之前的格子结果作废
+    quint64 m_generation = 0;
+    std::vector<Tile> m_tiles;
+    std::vector<cv::Mat> m_sources; ///< 各格子最近的处理结果（只读共享）
+    std::vector<std::shared_ptr<DisplayConvert::RangeTracker>> m_ranges;  ///< 各格子浮点结果的取值范围
+    std::vector<Canvas> m_canvases;
+    bool m_dirty = false;           ///< 有尚未合成的更新
+    bool m_compositing = false;     ///< 已安排合成，尚未完成
+};
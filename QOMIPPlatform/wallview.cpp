@@ -0,0 +1,171 @@
+#include "wallview.h"
+#include "basicviewwidget.h"
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QScreen>
+#include <QSettings>
+
+WallView::WallView(QWidget *parent)
+    : QWidget(parent, Qt::Window)
+{
+    setWindowTitle("视频墙");
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    resize(1280, 720);
+
+    // 合成结果在合成线程中交出，投递到GUI线程显示；窗口销毁后投递的事件自动丢弃
+    m_compositor = std::make_shared<WallCompositor>([this](const QImage &image) {
+        QMetaObject::invokeMethod(this, [this, image]() {
+            m_image = image;
+            update();
+        }, Qt::QueuedConnection);
+    });
+
+    /* 显示节奏：与 BasicViewWidget 相同，跟随屏幕刷新率或 `Scheduler/display_fps` 上限 */
+    QSettings settings("QOMIPPlatform", "Scheduler");
+    m_displayFpsCap = qMax(0, settings.value("display_fps", 0).toInt());
+    m_refreshTimer = new QTimer(this);
+    m_refreshTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_refreshTimer, &QTimer::timeout, this, [this]() {
+        m_compositor->requestComposite();
+    });
+}
+
+WallView::~WallView()
+{
+    for (const QMetaObject::Connection &connection : std::as_const(m_connections)) {
+        disconnect(connection);
+    }
+    // 正在进行的合成可能仍持有合成器，之后不再发布
+    m_compositor->shutdown();
+}
+
+void WallView::setViews(const QVector<BasicViewWidget*> &views)
+{
+    for (const QMetaObject::Connection &connection : std::as_const(m_connections)) {
+        disconnect(connection);
+    }
+    m_connections.clear();
+    m_views.clear();
+
+    // 在处理线程中直接把结果交给合成器；连接的函数对象持有合成器，调用期间不会被释放
+    for (int slot = 0; slot < views.size(); ++slot) {
+        BasicViewWidget *view = views[slot];
+        m_views.append(view);
+        std::shared_ptr<WallCompositor> compositor = m_compositor;
+        m_connections.append(connect(view->m_processor, &FrameProcessor::frameProcessed, this,
+            [compositor, slot](const SharedFrame &result) {
+                compositor->submit(slot, result.image());
+            }, Qt::DirectConnection));
+    }
+    if (m_focus >= m_views.size()) {
+        m_focus = -1;
+    }
+    updateLayout();
+}
+
+void WallView::updateLayout()
+{
+    // 隐藏或最小化时布局为空：处理线程交来的结果不再缩放和转换
+    const QSize canvasSize = isShowing() ? (QSizeF(size()) * devicePixelRatioF()).toSize() : QSize();
+    m_compositor->setLayout(canvasSize, m_views.size(), m_focus);
+    update();
+}
+
+int WallView::presentInterval() const
+{
+    const QScreen *current = screen();
+    double fps = current && current->refreshRate() > 0.0 ? current->refreshRate() : 60.0;
+    if (m_displayFpsCap > 0) {
+        fps = qMin<double>(fps, m_displayFpsCap);
+    }
+    return qMax(1, qRound(1000.0 / fps));
+}
+
+void WallView::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::black);
+    if (!m_image.isNull()) {
+        // 画布按窗口的物理像素尺寸分配，通常是 1:1 绘制；尺寸刚变化时暂时缩放
+        painter.drawImage(QRectF(rect()), m_image);
+    }
+
+    // 格子标题
+    const qreal ratio = devicePixelRatioF();
+    painter.setPen(Qt::white);
+    for (int slot = 0; slot < m_views.size(); ++slot) {
+        const QRect tile = m_compositor->tileRect(slot);
+        if (tile.isEmpty() || !m_views[slot]) {
+            continue;
+        }
+        const QRectF area(tile.x() / ratio, tile.y() / ratio, tile.width() / ratio, tile.height() / ratio);
+        painter.drawText(area.adjusted(6, 4, -6, -4), Qt::AlignLeft | Qt::AlignTop,
+                         m_views[slot]->getWidgetName());
+    }
+}
+
+void WallView::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    updateLayout();
+}
+
+void WallView::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    updateLayout();
+    m_refreshTimer->start(presentInterval());
+    emit visibilityChanged();
+}
+
+void WallView::hideEvent(QHideEvent *event)
+{
+    QWidget::hideEvent(event);
+    m_refreshTimer->stop();
+    m_image = QImage();     // 交还画布
+    updateLayout();
+    emit visibilityChanged();
+}
+
+void WallView::changeEvent(QEvent *event)
+{
+    QWidget::changeEvent(event);
+    if (event->type() == QEvent::WindowStateChange) {
+        if (isMinimized()) {
+            m_refreshTimer->stop();
+        } else if (isVisible()) {
+            m_refreshTimer->start(presentInterval());
+        }
+        updateLayout();
+        emit visibilityChanged();
+    }
+}
+
+void WallView::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton) {
+        QWidget::mousePressEvent(event);
+        return;
+    }
+    // 单击格子聚焦，聚焦时单击返回网格
+    if (m_focus >= 0) {
+        m_focus = -1;
+    } else {
+        const QPoint canvasPos = (event->position() * devicePixelRatioF()).toPoint();
+        m_focus = m_compositor->tileAt(canvasPos);
+    }
+    updateLayout();
+    event->accept();
+}
+
+void WallView::keyPressEvent(QKeyEvent *event)
+{
+    if (event->key() == Qt::Key_Escape && m_focus >= 0) {
+        m_focus = -1;
+        updateLayout();
+        event->accept();
+        return;
+    }
+    QWidget::keyPressEvent(event);
+}
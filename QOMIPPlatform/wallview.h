@@ -0,0 +1,66 @@
+#ifndef WALLVIEW_H
+#define WALLVIEW_H
+
+#include <QImage>
+#include <QPointer>
+#include <QTimer>
+#include <QVector>
+#include <QWidget>
+#include <memory>
+#include "wallcompositor.h"
+
+class BasicViewWidget;
+
+/**
+ * @class WallView
+ * @brief 视频墙窗口：把所有视图的处理结果以网格方式显示在一幅合成画布上
+ *
+ * 各视图的处理结果在处理线程中直接交给 WallCompositor，按格子尺寸缩小后合成，
+ * 本窗口每个显示周期只请求一次合成并绘制一幅图像，不为每个视图单独转换和绘制。
+ * 单击格子在整个窗口中显示该视图，再次单击或按 Esc 返回网格。
+ */
+class WallView : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit WallView(QWidget *parent = nullptr);
+    ~WallView() override;
+
+    /**
+     * @brief 设置要显示的视图（按顺序排列格子），视图增删后重新调用
+     */
+    void setViews(const QVector<BasicViewWidget*> &views);
+
+    /**
+     * @brief 窗口可见且未最小化
+     */
+    bool isShowing() const { return isVisible() && !isMinimized(); }
+
+signals:
+    /* 窗口显示、隐藏或最小化状态变化 */
+    void visibilityChanged();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+    void changeEvent(QEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+
+private:
+    /* 按当前尺寸、视图数和聚焦格子更新合成布局 */
+    void updateLayout();
+    int  presentInterval() const;
+
+    std::shared_ptr<WallCompositor> m_compositor;
+    QVector<QPointer<BasicViewWidget>> m_views;
+    QVector<QMetaObject::Connection> m_connections;
+    QImage  m_image;                // 最新合成的画布（引用合成器的缓冲）
+    QTimer *m_refreshTimer;         // 每个显示周期请求一次合成
+    int     m_focus = -1;           // 聚焦的格子，-1 表示网格
+    int     m_displayFpsCap = 0;    // 绘制帧率上限，0 表示跟随屏幕刷新率
+};
+
+#endif // WALLVIEW_H